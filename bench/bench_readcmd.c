@@ -0,0 +1,157 @@
+/*
+ * Banc d'essai de l'analyseur de lignes de commande (readcmd).
+ *
+ * Génère un script de lignes représentatives, puis le fait analyser par readcmd()
+ * en lisant soit le script projeté en mémoire, soit l'entrée standard.
+ * Les appels à malloc/realloc/calloc faits par readcmd.o et csapp.o sont comptés
+ * grâce à l'option d'édition de liens --wrap (voir la cible "bench" du Makefile).
+ *
+ * Chaque mode est mesuré avec chaque implémentation disponible de la recherche de délimiteurs (scan),
+ * sur les lignes représentatives puis sur des lignes longues (LONG_LINE_WORDS mots, ~50 Ko).
+ *
+ * Usage : bench_readcmd [nombre_de_lignes]
+ * Sortie : une ligne "clé=valeur ..." par mode et implémentation, pour être exploitée par des scripts.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "readcmd.h"
+#include "scan.h"
+
+static unsigned long nb_allocs = 0;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    nb_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    nb_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    nb_allocs++;
+    return __real_calloc(nmemb, size);
+}
+
+/* Lignes représentatives : pipelines, redirections, séquences, commentaires, et une ligne longue */
+static const char *sample_lines[] = {
+    "ls -l /tmp | grep foo | wc -l > out.txt",
+    "cat < in.txt | sort -n | uniq -c | sort -rn | head -n 10 >> out.txt",
+    "make -j8 && ./shell -b script.sh || echo failed ; true",
+    "sleep 1 & echo started # commentaire",
+    "ls /usr/share/doc/packages/libexample-common/changelog.Debian.gz /usr/lib/x86_64-linux-gnu/libexample.so.1.2.3 "
+    "/var/cache/generated/arguments/0000000000000000000000000001 /var/cache/generated/arguments/0000000000000000000000000002 "
+    "/var/cache/generated/arguments/0000000000000000000000000003 /var/cache/generated/arguments/0000000000000000000000000004",
+    "echo a b c d e f g h i j k l m n o p q r s t u v w x y z 0 1 2 3 4 5 6 7 8 9",
+    "",
+};
+
+/* Lignes longues : une commande et LONG_LINE_WORDS arguments, une ligne longue pour 2000 lignes courtes */
+#define LONG_LINE_WORDS 4096
+#define LONG_LINE_RATIO 2000
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Écrit nb_lines lignes (cycliques parmi sample_lines, ou lignes longues) dans un fichier temporaire.
+ * @param path Modèle de chemin pour mkstemp, remplacé par le chemin du fichier (à supprimer par l'appelant)
+ * @param nb_lines Le nombre de lignes
+ * @param long_lines 1 pour des lignes de LONG_LINE_WORDS arguments
+ * @return La taille du fichier en octets
+ */
+static long write_script(char *path, long nb_lines, int long_lines) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+    FILE *f = fdopen(fd, "w");
+    size_t nb_samples = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    for (long i = 0; i < nb_lines; i++) {
+        if (!long_lines) {
+            fprintf(f, "%s\n", sample_lines[i % nb_samples]);
+            continue;
+        }
+        fprintf(f, "echo");
+        for (int w = 0; w < LONG_LINE_WORDS; w++)
+            fprintf(f, w % 64 == 63 ? " | cat -v%d" : " argument%04d", w);
+        fprintf(f, "\n");
+    }
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+/**
+ * @brief Analyse toutes les lignes disponibles et affiche le résultat du mode.
+ */
+static void run(const char *mode, const char *scan, long bytes) {
+    unsigned long lines = 0, errors = 0;
+    unsigned long stat_lines, start_blocks, arena_blocks;
+    unsigned long start_allocs = nb_allocs;
+    struct cmdline *l;
+
+    readcmd_stats(&stat_lines, &start_blocks);
+    double t0 = now();
+    while ((l = readcmd()) != NULL) {
+        lines++;
+        if (l->err)
+            errors++;
+    }
+    double t1 = now();
+    readcmd_stats(&stat_lines, &arena_blocks);
+    unsigned long allocs = nb_allocs - start_allocs;
+
+    printf("mode=%s scan=%s lines=%lu errors=%lu ns_per_line=%.1f mb_per_s=%.1f allocs=%lu allocs_per_line=%.4f arena_blocks=%lu\n",
+           mode, scan, lines, errors, lines ? (t1 - t0) * 1e9 / lines : 0.0, bytes / (t1 - t0) / (1 << 20),
+           allocs, lines ? (double)allocs / lines : 0.0, arena_blocks - start_blocks);
+}
+
+int main(int argc, char *argv[]) {
+    long nb_lines = argc > 1 ? atol(argv[1]) : 1000000;
+    static const char *scan_names[] = {"scalar", "sse2", "avx2"};
+    static const char *stdin_modes[] = {"stdin", "stdin_long"}, *script_modes[] = {"script", "script_long"};
+    char paths[2][sizeof("/tmp/bench_readcmdXXXXXX")] = {"/tmp/bench_readcmdXXXXXX", "/tmp/bench_readcmdXXXXXX"};
+    long bytes[2];
+
+    bytes[0] = write_script(paths[0], nb_lines, 0);
+    bytes[1] = write_script(paths[1], nb_lines / LONG_LINE_RATIO + 1, 1);
+
+    // Entrée standard (lue par blocs, lignes copiées dans l'arène)
+    for (int k = 0; k < 2; k++) {
+        for (int impl = SCAN_SCALAR; impl <= scan_best(); impl++) {
+            scan_select(impl);
+            if (freopen(paths[k], "r", stdin) == NULL) {
+                perror(paths[k]);
+                return 1;
+            }
+            run(stdin_modes[k], scan_names[impl], bytes[k]);
+        }
+    }
+
+    // Script projeté en mémoire (découpage sur place) : readcmd ne revient plus ensuite à l'entrée standard
+    for (int k = 0; k < 2; k++) {
+        for (int impl = SCAN_SCALAR; impl <= scan_best(); impl++) {
+            scan_select(impl);
+            if (readcmd_open_script(paths[k]) < 0) {
+                perror(paths[k]);
+                return 1;
+            }
+            run(script_modes[k], scan_names[impl], bytes[k]);
+        }
+        unlink(paths[k]);
+    }
+    return 0;
+}
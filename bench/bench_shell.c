@@ -0,0 +1,190 @@
+/*
+ * Banc d'essai du lancement des commandes, lancé par "make bench" après bench_readcmd.
+ *
+ * Les lignes de commande sont analysées par readcmd() puis exécutées directement par
+ * execute_command_line(), comme dans le shell (bench est lié à tous les modules sauf shell.o) :
+ *   1. latence de lancement d'une commande simple ;
+ *   2. mise en place d'une séquence de N pipes, N = 1, 2, 4, ..., 256 ;
+ *   3. débit à travers les pipes de execute_command_line (gros transferts, étapes intégrées et externes) ;
+ *   4. opérations sur la table des jobs avec 10 000 jobs.
+ *
+ * Usage : bench_shell [facteur]   (facteur > 1 : plus d'exécutions par mesure)
+ * Sortie : une ligne "bench=... clé=valeur ..." par mesure, pour comparer deux versions par script.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "execute.h"
+#include "jobs.h"
+#include "readcmd.h"
+
+#define NB_JOBS 10000
+#define TRANSFER_SIZE (256L << 20)
+#define FAKE_PID_BASE 5000000 /* au-delà de pid_max : aucun processus réel désigné */
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Analyse line avec readcmd (à travers un script temporaire).
+ * @return La ligne analysée, valide jusqu'au prochain appel
+ */
+static struct cmdline *parse(const char *line) {
+    char path[] = "/tmp/bench_shellXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, line, strlen(line)) < 0 || write(fd, "\n", 1) < 0) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+    if (readcmd_open_script(path) < 0) {
+        perror(path);
+        exit(1);
+    }
+    struct cmdline *l = readcmd();
+    unlink(path);
+    if (l == NULL || l->err) {
+        fprintf(stderr, "bench_shell: ligne invalide: %s\n", line);
+        exit(1);
+    }
+    return l;
+}
+
+/**
+ * @brief Exécute runs fois la ligne et affiche moyenne, p50, p99 et max de la durée d'une exécution,
+ * et le débit moyen si la ligne transfère bytes octets (bytes > 0).
+ */
+static void run_line(const char *bench, const char *extra, const char *line, int runs, long bytes) {
+    struct cmdline *l = parse(line);
+    double *t = malloc(runs * sizeof(double));
+    double sum = 0;
+    int failures = 0;
+
+    for (int i = 0; i < runs; i++) {
+        double t0 = now();
+        if (execute_command_line(l) != 0)
+            failures++;
+        t[i] = now() - t0;
+        sum += t[i];
+    }
+    qsort(t, runs, sizeof(double), compare_double);
+    printf("bench=%s %sruns=%d failures=%d mean_us=%.1f p50_us=%.1f p99_us=%.1f max_us=%.1f",
+           bench, extra, runs, failures, sum / runs * 1e6, t[(runs * 50 + 99) / 100 - 1] * 1e6,
+           t[(runs * 99 + 99) / 100 - 1] * 1e6, t[runs - 1] * 1e6);
+    if (bytes > 0)
+        printf(" mb_per_s=%.1f", bytes / (sum / runs) / (1 << 20));
+    printf("\n");
+    fflush(stdout);
+    free(t);
+}
+
+/**
+ * @brief Latence de lancement d'une commande simple.
+ */
+static void bench_launch(int factor) {
+    run_line("launch", "cmd=/bin/true ", "/bin/true", 500 * factor, 0);
+}
+
+/**
+ * @brief Mise en place d'une séquence de n étapes /bin/true reliées par des pipes.
+ */
+static void bench_pipeline(int factor) {
+    char *line = malloc(256 * sizeof(" | /bin/true"));
+    char extra[32];
+
+    for (int n = 1; n <= 256; n *= 2) {
+        line[0] = '\0';
+        for (int i = 0; i < n; i++)
+            strcat(line, i == 0 ? "/bin/true" : " | /bin/true");
+        snprintf(extra, sizeof(extra), "stages=%d ", n);
+        run_line("pipeline", extra, line, (n <= 16 ? 50 : 10) * factor, 0);
+    }
+    free(line);
+}
+
+/**
+ * @brief Débit d'une séquence de pipes qui transfère TRANSFER_SIZE octets (étapes cat intégrées ou externes).
+ */
+static void bench_throughput(int factor) {
+    static const struct {
+        const char *name;
+        const char *line;
+    } cases[] = {
+        { "builtin_cat_x2",  "head -c %ld /dev/zero | cat | cat > /dev/null" },
+        { "external_cat_x2", "head -c %ld /dev/zero | /bin/cat | /bin/cat > /dev/null" },
+        { "builtin_cat_x8",  "head -c %ld /dev/zero | cat | cat | cat | cat | cat | cat | cat | cat > /dev/null" },
+    };
+    char line[256], extra[64];
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        snprintf(line, sizeof(line), cases[i].line, TRANSFER_SIZE);
+        snprintf(extra, sizeof(extra), "case=%s bytes=%ld ", cases[i].name, TRANSFER_SIZE);
+        run_line("throughput", extra, line, 3 * factor, TRANSFER_SIZE);
+    }
+}
+
+/**
+ * @brief Opérations sur la table des jobs avec NB_JOBS jobs de trois étapes (pid fictifs).
+ * add_ns comprend les trois pidfd_open de add_job, qui échouent ici (ESRCH) sans ouvrir de descripteur.
+ */
+static void bench_jobs(void) {
+    char cmd[32];
+    pid_t pids[3];
+
+    jobs_init();
+    double t0 = now();
+    for (int i = 0; i < NB_JOBS; i++) {
+        snprintf(cmd, sizeof(cmd), "job %d", i + 1);
+        for (int k = 0; k < 3; k++)
+            pids[k] = FAKE_PID_BASE + 3 * i + k;
+        add_job(pids[0], JOB_RUNNING, cmd, pids, 3);
+    }
+    double t1 = now();
+    int found = 0;
+    for (int i = 0; i < NB_JOBS; i++)
+        found += get_job_by_jid(i + 1) != NULL;
+    double t2 = now();
+    for (int i = 0; i < NB_JOBS; i++)
+        found += get_job_by_pgid(FAKE_PID_BASE + 3 * i) != NULL;
+    double t3 = now();
+    for (int i = 0; i < NB_JOBS; i++)
+        found += get_proc_by_pid(FAKE_PID_BASE + 3 * i + 2) != NULL;
+    double t4 = now();
+    for (int i = 0; i < NB_JOBS; i++)
+        job_transition(get_job_by_jid(i + 1), JOB_MASK(JOB_RUNNING), JOB_STOPPED);
+    double t5 = now();
+    for (int i = 0; i < NB_JOBS; i++)
+        delete_job_by_jid(i + 1);
+    double t6 = now();
+
+    printf("bench=jobs jobs=%d procs_per_job=3 found=%d add_ns=%.1f by_jid_ns=%.1f by_pgid_ns=%.1f by_pid_ns=%.1f "
+           "transition_ns=%.1f delete_ns=%.1f\n", NB_JOBS, found,
+           (t1 - t0) * 1e9 / NB_JOBS, (t2 - t1) * 1e9 / NB_JOBS, (t3 - t2) * 1e9 / NB_JOBS,
+           (t4 - t3) * 1e9 / NB_JOBS, (t5 - t4) * 1e9 / NB_JOBS, (t6 - t5) * 1e9 / NB_JOBS);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int factor = argc > 1 ? atoi(argv[1]) : 1;
+    if (factor < 1)
+        factor = 1;
+
+    bench_jobs();
+
+    // Table des jobs vide et boucle d'événements, comme au démarrage du shell
+    setup_signals_handlers_shell();
+    bench_launch(factor);
+    bench_pipeline(factor);
+    bench_throughput(factor);
+    return 0;
+}
@@ -12,4 +12,25 @@
  */
 int execute_builtin(struct cmdline *cmd);
 
+/**
+ * @brief Commande intégrée utilisable comme étape d'une séquence de commandes (echo, true, false, printf, cat).
+ *
+ * Elle lit sur fd_in et écrit sur fd_out avec read/write (pas de stdio), et renvoie son code de retour.
+ * Seule dans la ligne de commande, elle s'exécute dans le shell ; dans une séquence, elle s'exécute
+ * dans le processus fils sans execvp.
+ */
+typedef int (*stage_builtin_t)(char **argv, int fd_in, int fd_out);
+
+/**
+ * @brief Recherche la commande intégrée d'étape correspondant à une commande simple.
+ *
+ * @param argv La commande simple (argv[0] est le nom de la commande)
+ * @param in_shell 1 si la commande doit être exécutée dans le shell lui-même, 0 si elle le sera dans un fils.
+ * Dans le shell, les commandes qui liraient l'entrée standard (cat sans fichier) ou autre chose que des
+ * fichiers ordinaires (cat /dev/zero, cat fifo) ne sont pas retenues : hors de tout job, Ctrl+C ne
+ * pourrait pas les arrêter.
+ * @return stage_builtin_t la commande intégrée, ou NULL si la commande doit être lancée avec execvp.
+ */
+stage_builtin_t find_stage_builtin(char **argv, int in_shell);
+
 #endif
@@ -0,0 +1,76 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+#include "readcmd.h"
+
+/**
+ * @brief Cache des résultats de commandes déterministes (préfixe cache).
+ *
+ * Une entrée est identifiée par un hachage FNV-1a 64 bits de la ligne de commande (mots de chaque
+ * étape), du fichier de redirection d'entrée (périphérique, inode, taille, date de modification)
+ * ou du contenu du here-document, du répertoire courant et de quelques variables d'environnement
+ * qui changent la sortie des commandes usuelles (PATH, LANG, LC_ALL, LC_COLLATE, LC_CTYPE, TZ).
+ * Les fichiers nommés en argument ne sont pas suivis : --ttl borne l'âge des entrées.
+ *
+ * Chaque entrée est un fichier de $XDG_CACHE_HOME/shell (par défaut ~/.cache/shell) nommé par
+ * le hachage en hexadécimal : un en-tête (code de retour) suivi de la sortie standard. Elle est
+ * écrite dans un fichier temporaire du même répertoire, puis mise en place par rename une fois la
+ * commande terminée : une entrée visible est toujours complète. Une entrée refusée par cache_open
+ * parce que trop vieille est supprimée ; cache_clear vide tout le répertoire.
+ */
+
+/**
+ * @brief Calcule la clé de la ligne de commande c.
+ * @param c La ligne de commande (sans le préfixe cache)
+ * @param key La clé calculée
+ * @return int 0 si succès, -1 si la redirection d'entrée est illisible (errno positionné)
+ */
+int cache_key(struct cmdline *c, uint64_t *key);
+
+/**
+ * @brief Ouvre l'entrée key si elle existe et n'a pas plus de ttl secondes.
+ * @param key La clé
+ * @param ttl L'âge maximal en secondes, -1 pour ne pas limiter
+ * @param status Le code de retour enregistré
+ * @return int Un descripteur positionné au début de la sortie enregistrée, -1 si absente ou périmée
+ * (une entrée périmée ou invalide est supprimée)
+ */
+int cache_open(uint64_t key, long ttl, int *status);
+
+/**
+ * @brief Crée le fichier temporaire d'une nouvelle entrée, à compléter en ajout (O_APPEND) par la
+ * commande puis à valider par cache_commit ou abandonner par cache_abort.
+ * @return char* Le chemin du fichier temporaire (à libérer par cache_commit ou cache_abort), NULL si
+ * le répertoire du cache est inutilisable
+ */
+char *cache_begin(void);
+
+/**
+ * @brief Enregistre le code de retour dans l'en-tête du fichier temporaire et le met en place comme
+ * entrée key.
+ * @param tmp Le chemin renvoyé par cache_begin (libéré)
+ * @param key La clé
+ * @param status Le code de retour de la commande
+ * @return int 0 si succès, -1 sinon (fichier temporaire supprimé)
+ */
+int cache_commit(char *tmp, uint64_t key, int status);
+
+/**
+ * @brief Supprime le fichier temporaire d'une entrée abandonnée.
+ * @param tmp Le chemin renvoyé par cache_begin (libéré)
+ */
+void cache_abort(char *tmp);
+
+/**
+ * @brief Supprime toutes les entrées du cache, et les fichiers temporaires abandonnés.
+ * @return int Le nombre de fichiers supprimés, -1 si le répertoire du cache est inutilisable
+ */
+int cache_clear(void);
+
+/**
+ * @brief Affiche le répertoire du cache et les succès et échecs depuis le démarrage du shell.
+ */
+void cache_print_status(void);
+
+#endif /* CACHE_H */
@@ -0,0 +1,87 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <signal.h>
+#include <time.h>
+
+/**
+ * @brief Boucle d'événements du shell (epoll).
+ *
+ * Le shell n'installe aucun traitant de signal asynchrone : les signaux qu'il gère (SIGCHLD, SIGINT,
+ * SIGTSTP) sont bloqués en permanence et lus sur un signalfd, surveillé par epoll avec l'entrée
+ * en cours de lecture et un minuteur (timerfd). Les traitants enregistrés par events_on_signal sont
+ * appelés par events_wait dans le contexte normal du shell : ils peuvent utiliser printf, malloc
+ * et modifier la table des jobs sans précaution particulière.
+ * Les fils retrouvent le masque de signaux d'origine (events_child_mask).
+ */
+
+/* Événements retournés par events_wait */
+#define EVENT_INPUT  1 /* Le descripteur surveillé est lisible (données, fin de fichier ou erreur) */
+#define EVENT_TIMER  2 /* Le minuteur est arrivé à échéance */
+#define EVENT_SIGNAL 4 /* Au moins un signal a été traité */
+
+/**
+ * @brief Traitant d'un signal, appelé par events_wait (contexte normal, pas de contexte de signal).
+ * @param signum Le numéro du signal reçu
+ */
+typedef void (*event_handler_t)(int signum);
+
+/**
+ * @brief Crée l'instance epoll, le signalfd (vide) et le minuteur.
+ */
+void events_init(void);
+
+/**
+ * @brief Bloque signum et le fait traiter par handler à chaque passage dans events_wait.
+ * @param signum Le signal à surveiller
+ * @param handler Le traitant associé, NULL pour ne plus surveiller signum (débloqué, sauf s'il l'était
+ * déjà avant events_init)
+ * @return event_handler_t Le traitant précédent (NULL si signum n'était pas surveillé), à rétablir
+ * par un nouvel appel
+ */
+event_handler_t events_on_signal(int signum, event_handler_t handler);
+
+/**
+ * @brief Masque de signaux à appliquer dans les fils : celui du shell avant events_on_signal.
+ */
+const sigset_t *events_child_mask(void);
+
+/**
+ * @brief Indique si un SIGINT (Ctrl+C) attend d'être lu sur le signalfd, sans le consommer : pour
+ * interrompre un travail fait dans le shell lui-même, hors de tout job de premier plan. Il sera traité
+ * comme d'habitude au prochain events_wait.
+ * @return int 1 si SIGINT est en attente, 0 sinon (toujours 0 dans un fils, où SIGINT n'est pas bloqué)
+ */
+int events_interrupt_pending(void);
+
+/**
+ * @brief Attend le prochain événement, en traitant les signaux reçus avant de rendre la main.
+ * Sans events_init (bancs d'essai, tests), retourne immédiatement EVENT_INPUT.
+ * @param fd Descripteur à surveiller en lecture, -1 pour n'attendre que les signaux et le minuteur.
+ * Un fichier ordinaire (que epoll refuse) est considéré comme toujours lisible.
+ * @return int Combinaison de EVENT_INPUT, EVENT_TIMER et EVENT_SIGNAL
+ */
+int events_wait(int fd);
+
+/**
+ * @brief Attend, avec poll, qu'un des descripteurs de fds soit lisible (pidfd d'un processus terminé...),
+ * ou un signal, ou le minuteur : pour un ensemble de descripteurs propre à une seule attente, sans
+ * les enregistrer dans epoll. Les signaux reçus sont traités avant de rendre la main.
+ * @param fds Les descripteurs à surveiller en lecture
+ * @param nb_fds Leur nombre (0 : seulement les signaux et le minuteur)
+ * @return int Combinaison de EVENT_INPUT (un descripteur de fds est lisible), EVENT_TIMER et EVENT_SIGNAL
+ */
+int events_poll(const int *fds, int nb_fds);
+
+/**
+ * @brief Arme le minuteur : events_wait ou events_poll retournera EVENT_TIMER une fois le délai écoulé.
+ * @param delay Le délai (CLOCK_MONOTONIC), NULL pour désarmer le minuteur
+ */
+void events_set_timer(const struct timespec *delay);
+
+/**
+ * @brief Affiche les statistiques de la boucle : réveils, signaux lus et traitants appelés.
+ */
+void events_print_stats(void);
+
+#endif /* EVENTS_H */
@@ -5,15 +5,29 @@
 #include <stdlib.h>
 #include "readcmd.h"
 #include "csapp.h"
+#include "jobs.h"
 
 
 /**
  * @brief Initialiser le comportement du shell vis-à-vis des signaux et du contrôle du terminal
- * 
+ * SIGCHLD, SIGINT et SIGTSTP sont confiés à la boucle d'événements (events_on_signal) : leurs traitants
+ * ne s'exécutent que dans events_wait, jamais de façon asynchrone.
  */
 void setup_signals_handlers_shell();
 
 
+/**
+ * @brief Récolte tous les enfants terminés ou suspendus et met à jour la table des jobs (notifications
+ * Stopped et Done). Traitant de SIGCHLD pour la boucle d'événements.
+ * @param signum Le numéro du signal (non utilisé)
+ */
+void sigchld_handler(int signum);
+
+/**
+ * @brief Convertit un statut waitpid en code de retour à la manière de bash (128 + signal si tué ou suspendu).
+ */
+int exit_code_of(int status);
+
 /**
  * @brief Exécute une ligne de commande avec la gestion des redirections, des pipes et du background. 
  * 
@@ -22,12 +36,55 @@ void setup_signals_handlers_shell();
  */
 int execute_command_line(struct cmdline *l);
 
+/**
+ * @brief Lance une commande simple en arrière-plan, sans notification, et l'ajoute à la table des jobs.
+ *
+ * @param argv La commande simple à exécuter
+ * @param fd_in Descripteur de fichier pour l'entrée de la commande
+ * @param fd_out Descripteur de fichier pour la sortie de la commande
+ * @param on_done Fonction appelée par sigchld_handler (depuis events_wait) à la fin du job
+ * @return pid_t le pgid du job, ou -1 si le job n'a pas pu être ajouté à la table (il a alors été attendu et on_done appelée)
+ */
+pid_t launch_background_command(char **argv, int fd_in, int fd_out, job_done_hook_t on_done);
+
+/**
+ * @brief Retourne le descripteur de /dev/null partagé par les jobs en arrière-plan, ouvert une fois
+ * (O_RDWR | O_CLOEXEC) puis gardé : à ne pas fermer.
+ *
+ * @return int le descripteur, -1 si /dev/null n'a pas pu être ouvert (errno positionné)
+ */
+int get_devnull_fd(void);
+
+/**
+ * @brief Fixe la taille des buffers des pipes créés pour les prochaines séquences de commandes.
+ *
+ * @param size La taille souhaitée en octets (0 pour la taille par défaut du noyau), limitée à /proc/sys/fs/pipe-max-size
+ * (à INT_MAX s'il est illisible). Un refus de F_SETPIPE_SZ à la création des pipes est signalé une fois.
+ * @return int la taille effectivement retenue
+ */
+int set_pipe_buffer_size(long size);
+
+/**
+ * @brief Retourne la taille des buffers de pipe configurée (0 si taille par défaut du noyau).
+ */
+int get_pipe_buffer_size(void);
+
+/**
+ * @brief Exécute une séquence de lignes de commande séparées par ;, && ou || (champ next de cmdline),
+ * chacune étant un builtin ou une séquence de commandes avec pipes.
+ *
+ * @param l Un pointeur vers la première cmdline de la séquence.
+ * @return int code de retour de la dernière ligne de commande exécutée.
+ */
+int execute_command_sequence(struct cmdline *l);
+
 /**
  * @brief Attend que le job de premier plan (pgid) disparaisse du foreground.
  *
  * @param pgid Le pgid du groupe de processus du job de premier plan
+ * @return int code de retour du job (128 + numéro du signal s'il a été tué ou suspendu)
  */
-void wait_for_fg_job(pid_t pgid);
+int wait_for_fg_job(pid_t pgid);
 
 
 #endif
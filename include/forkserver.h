@@ -0,0 +1,51 @@
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include <sys/types.h>
+
+/**
+ * @brief Serveur de lancement (option -z du shell) : un processus auxiliaire, lancé au démarrage et
+ * ré-exécuté (/proc/self/exe) pour n'avoir qu'un espace d'adressage minimal, fait les fork/exec à la
+ * place du shell. Le shell lui envoie sur une socketpair le chemin, argv et le pgid, avec les
+ * descripteurs d'entrée, de sortie et d'erreur (SCM_RIGHTS).
+ *
+ * L'auxiliaire crée la commande par clone(CLONE_PARENT | CLONE_VM | CLONE_VFORK) : comme avec
+ * posix_spawn, pas de copie de l'espace d'adressage et la réponse n'arrive qu'après l'exec (ou son
+ * échec), mais la commande est un enfant du shell, qui la récolte comme les autres (sigchld_handler,
+ * pidfd). Elle se place elle-même dans son groupe avant l'exec : groupes de processus et terminal
+ * restent gérés par le shell.
+ *
+ * La commande hérite du répertoire courant, de l'environnement et du masque de signaux de l'auxiliaire,
+ * c'est-à-dire ceux du shell au démarrage (le shell n'a ni cd ni export, et l'auxiliaire est lancé
+ * avant events_init) ; SIGINT, SIGQUIT, SIGTSTP, SIGTTIN et SIGTTOU, ignorés par l'auxiliaire, sont
+ * remis au comportement par défaut.
+ */
+
+/**
+ * @brief Lance l'auxiliaire.
+ * @param exe Le chemin de l'exécutable du shell (repli si /proc/self/exe est absent)
+ * @return int 0 si succès, -1 sinon (les commandes sont alors lancées par posix_spawn)
+ */
+int forkserver_start(const char *exe);
+
+/**
+ * @brief Boucle de l'auxiliaire (shell --fork-server fd) : ne retourne pas, se termine quand le shell
+ * ferme la socket.
+ * @param fd L'extrémité de la socketpair côté auxiliaire
+ */
+void forkserver_main(int fd) __attribute__((noreturn));
+
+/**
+ * @brief Fait lancer path par l'auxiliaire.
+ * @param pid Le pid de la commande lancée
+ * @param path Le chemin de l'exécutable
+ * @param argv Les arguments (terminés par NULL)
+ * @param fd_in Descripteur à placer en entrée standard de la commande
+ * @param fd_out Descripteur à placer en sortie standard de la commande
+ * @param pgid Le groupe à rejoindre, 0 pour en créer un
+ * @return int 0 si succès, un code errno (comme posix_spawn) si l'exec a échoué, -1 si l'auxiliaire
+ * n'est pas lancé ou ne répond plus (l'appelant se replie sur posix_spawn)
+ */
+int forkserver_spawn(pid_t *pid, const char *path, char *const argv[], int fd_in, int fd_out, pid_t pgid);
+
+#endif /* FORKSERVER_H */
@@ -3,8 +3,9 @@
 
 #include <sys/types.h>
 #include <signal.h>
+#include <time.h>
+#include <sys/resource.h>
 
-#define MAXJOBS    100
 #define MAXCMDLEN  512
 
 /**
@@ -14,59 +15,115 @@
  * JOB_FOREGROUND : exécuté au premier plan
  * JOB_RUNNING : exécuté en arrière-plan
  * JOB_STOPPED : suspendu (SIGTSTP / SIGSTOP)
+ * JOB_DONE : terminé, marqué par sigchld_handler ; invisible pour les recherches et retiré
+ *            de la table au prochain add_job
  */
 typedef enum {
     JOB_UNDEF      = 0,
     JOB_FOREGROUND = 1,
     JOB_RUNNING    = 2,
     JOB_STOPPED    = 3,
+    JOB_DONE       = 4,
 } job_state_t;
 
+/* Ensemble d'états de départ pour job_transition */
+#define JOB_MASK(state) (1u << (state))
+#define JOB_ACTIVE_MASK (JOB_MASK(JOB_FOREGROUND) | JOB_MASK(JOB_RUNNING) | JOB_MASK(JOB_STOPPED))
+
 /**
- * @brief Structure de job.
+ * @brief État d'un processus (étape) d'un job.
  */
-typedef struct {
-    int          jid;
-    pid_t        pgid;
-    job_state_t  state;
-    char         cmdline[MAXCMDLEN];
-} job_t;
+typedef enum {
+    PROC_RUNNING = 0,
+    PROC_STOPPED = 1,
+    PROC_DONE    = 2,
+} proc_state_t;
 
+struct job;
 
 /**
- * @brief Initialise la table des jobs.
+ * @brief Processus d'un job (une étape de la séquence de pipes).
  */
-void jobs_init();
+typedef struct proc {
+    pid_t                  pid;
+    proc_state_t           state;
+    int                    status;   /* Statut waitpid, valide une fois PROC_DONE */
+    struct timespec        end;      /* Date de fin (CLOCK_MONOTONIC), valide une fois PROC_DONE */
+    struct rusage          rusage;   /* Ressources consommées (wait4), valides une fois PROC_DONE */
+    int                    pidfd;    /* pidfd_open du processus, -1 si indisponible ; fermé à sa fin, sauf
+                                        pour le chef de groupe (première étape) : gardé jusqu'au retrait du job */
+    struct job            *job;      /* Job contenant le processus */
+    struct proc           *pid_next; /* Suivant dans l'index par pid */
+} proc_t;
 
 /**
- * @brief Bloque SIGCHLD et sauvegarde l'ancien masque dans *old_mask.
- * @param old_mask Pointeur vers le masque de signaux à sauvegarder
+ * @brief Fonction appelée par sigchld_handler quand un job se termine (depuis la boucle d'événements,
+ * dans le contexte normal du shell).
+ * @param pgid Le pgid du job terminé
+ * @param status Le statut renvoyé par waitpid
  */
-void jobs_block_sigchld(sigset_t *old_mask);
+typedef void (*job_done_hook_t)(pid_t pgid, int status);
 
 /**
- * @brief Rétablit le masque de signaux sauvegardé dans *old_mask.
- * @param old_mask Pointeur vers le masque de signaux à restaurer
+ * @brief Structure de job.
+ *
+ * Les jobs sont alloués par blocs qui ne sont jamais déplacés ni libérés : un job_t * reste valide
+ * (éventuellement recyclé pour un autre job) après la suppression du job.
+ * L'état ne change que par job_transition (et set_job_state, mark_job_stopped, mark_job_done), qui
+ * n'accepte que certains états de départ et tient à jour le job au premier plan et le nombre de jobs
+ * en arrière-plan. La table n'est utilisée que dans le contexte normal du shell : les signaux sont
+ * traités par la boucle d'événements (events_wait), jamais de façon asynchrone.
  */
-void jobs_unblock_sigchld(const sigset_t *old_mask);
+typedef struct job {
+    int              jid;
+    pid_t            pgid;
+    job_state_t      state;
+    int              status;  /* Statut waitpid de la dernière étape, valide une fois le job JOB_DONE */
+    char             cmdline[MAXCMDLEN];
+    proc_t          *procs;   /* Un processus par étape, dans l'ordre de la séquence */
+    int              nb_procs;
+    int              procs_capacity;
+    int              nb_alive; /* Processus pas encore terminés : le job se termine quand il tombe à 0 */
+    struct timespec  start;   /* Date de lancement (CLOCK_MONOTONIC) */
+    struct timespec  spawned; /* Date à laquelle toutes les étapes sont lancées (retour du dernier spawn ou fork) */
+    int              timed;   /* Lancé par le préfixe time : rapport des ressources consommées à sa fin */
+    job_done_hook_t  on_done; /* Si non NULL, appelée à la fin du job à la place de la notification Done */
+    struct job      *done_next; /* Suivant dans la pile des jobs terminés à retirer */
+    struct job      *pgid_next; /* Suivant dans l'index par pgid (ou dans la liste des cases libres) */
+    struct job      *jid_next;  /* Suivant dans l'index par jid */
+    struct job      *prev;      /* Liste des jobs par jid croissant */
+    struct job      *next;
+} job_t;
+
 
 /**
- * @brief Ajoute un nouveau job dans le tableau.
+ * @brief Initialise la table des jobs (vide, sans limite de taille : elle grandit à la demande).
+ */
+void jobs_init();
+
+/**
+ * @brief Ajoute un nouveau job dans la table, avec le jid suivant le plus grand jid actif.
  * @param pgid Le pgid du groupe de processus du job
  * @param state L'état initial du job
  * @param cmdline La ligne de commande associée au job
- * @return jid du nouveau job (>= 1), ou -1 si le tableau est plein.
- *
- * IMPORTANT : appeler jobs_block_sigchld() AVANT cette fonction.
+ * @param pids Les pid des processus du job, un par étape dans l'ordre de la séquence
+ * @param nb_pids Le nombre de processus (>= 1)
+ * @return jid du nouveau job (>= 1), ou -1 si la mémoire manque pour agrandir la table.
+ */
+int add_job(pid_t pgid, job_state_t state, const char *cmdline, const pid_t *pids, int nb_pids);
+
+/**
+ * @brief Associe une fonction de fin au job identifié par jid.
+ * @param jid Le numéro du job
+ * @param on_done La fonction appelée à la fin du job (NULL pour la notification Done habituelle)
+ * @return 0 si trouvé, -1 sinon.
  */
-int add_job(pid_t pgid, job_state_t state, const char *cmdline);
+int set_job_done_hook(int jid, job_done_hook_t on_done);
 
 /**
- * @brief Supprime le job identifié par son jid et libère la case.
+ * @brief Supprime le job identifié par son jid et remet sa case dans la liste des cases libres.
  * @param jid Le numéro du job à supprimer
  * @return 0 si trouvé et supprimé, -1 sinon.
- *
- * IMPORTANT : appeler jobs_block_sigchld() AVANT cette fonction.
  */
 int delete_job_by_jid(int jid);
 
@@ -74,8 +131,6 @@ int delete_job_by_jid(int jid);
  * @brief Supprime le job identifié par son pgid.
  * @param pgid Le pgid du groupe de processus du job à supprimer
  * @return 0 si trouvé et supprimé, -1 sinon.
- *
- * IMPORTANT : appeler jobs_block_sigchld() AVANT cette fonction.
  */
 int delete_job_by_pgid(pid_t pgid);
 
@@ -96,13 +151,33 @@ job_t *get_job_by_jid(int jid);
 job_t *get_job_by_pgid(pid_t pgid);
 
 /**
- * @brief Retourne le job actuellement au premier plan, NULL s'il n'y en a pas.
+ * @brief Retourne le processus actif (pas encore terminé) de pid donné, NULL sinon.
+ * @param pid Le pid recherché (n'importe quelle étape d'un job)
+ * @return Pointeur sur le processus trouvé (proc->job est son job), NULL si aucun.
+ */
+proc_t *get_proc_by_pid(pid_t pid);
+
+/**
+ * @brief Retourne le job actuellement au premier plan, NULL s'il n'y en a pas (en O(1)).
  * @return Pointeur sur le job au foreground, ou NULL s'il n'y en a pas.
  */
 job_t *get_fg_job();
 
 /**
- * @brief Résout un argument de la forme "%N" (numéro de job) ou "<pid>".
+ * @brief Parcourt les jobs actifs par jid croissant.
+ * @param j Le job précédent, NULL pour obtenir le premier
+ * @return Pointeur sur le job actif suivant, NULL à la fin de la table.
+ */
+job_t *get_next_job(job_t *j);
+
+/**
+ * @brief Retourne le job courant : celui de plus grand jid qui n'est pas au premier plan.
+ * @return Pointeur sur le job courant, NULL s'il n'y en a pas.
+ */
+job_t *get_current_job(void);
+
+/**
+ * @brief Résout un argument de la forme "%N" (numéro de job) ou "<pid>" (pgid du job ou pid d'une de ses étapes).
  * @param arg L'argument à résoudre
  * @return Pointeur sur le job trouvé, NULL si l'argument est invalide ou inconnu.
  */
@@ -110,29 +185,100 @@ job_t *resolve_job_arg(const char *arg);
 
 
 /**
- * @brief Change l'état du job identifié par jid.
+ * @brief Change l'état d'un job, si son état courant fait partie de from.
+ * @param j Le job
+ * @param from Les états de départ acceptés (JOB_MASK(...) combinés)
+ * @param to Le nouvel état
+ * @return int L'état précédent si la transition a eu lieu, -1 sinon (job terminé entre-temps...).
+ */
+int job_transition(job_t *j, unsigned from, job_state_t to);
+
+/**
+ * @brief Change l'état du job actif identifié par jid.
  * @param jid Le numéro du job à mettre à jour
  * @param state Le nouvel état du job
  * @return 0 si trouvé, -1 sinon.
- *
- * IMPORTANT : appeler jobs_block_sigchld() AVANT cette fonction.
  */
 int set_job_state(int jid, job_state_t state);
 
 /**
- * @brief Change l'état du job identifié par pgid.
+ * @brief Change l'état du job actif identifié par pgid.
  * @return 0 si trouvé, -1 sinon.
  */
 int set_job_state_by_pgid(pid_t pgid, job_state_t state);
 
+/**
+ * @brief Envoie un signal à tout le groupe de processus du job, par le pidfd de son chef
+ * (pidfd_send_signal) : un pid ou un pgid réattribué entre-temps ne peut pas être touché.
+ * Sans pidfd ou sur un noyau trop ancien, repli sur kill(-pgid), sûr tant qu'un processus du job n'a pas été récolté.
+ * @param j Le job
+ * @param sig Le signal à envoyer
+ * @return int 0 si succès, -1 sinon (errno positionné, ESRCH si tout le job est terminé)
+ */
+int job_signal(job_t *j, int sig);
+
+/**
+ * @brief Copie dans fds les pidfd des processus du job pas encore terminés (lisibles à leur fin).
+ * @param j Le job
+ * @param fds Tableau d'au moins j->nb_procs cases
+ * @return int Le nombre de pidfd copiés (les processus sans pidfd ne sont signalés que par SIGCHLD)
+ */
+int job_pidfds(job_t *j, int *fds);
+
+/**
+ * @brief sigchld_handler : marque un processus comme suspendu.
+ */
+void mark_proc_stopped(proc_t *p);
+
+/**
+ * @brief sigchld_handler : enregistre la fin d'un processus (statut, date et ressources). Si c'était le dernier
+ * processus actif de son job, le job passe à JOB_DONE avec le statut de sa dernière étape.
+ * @param p Le processus récolté
+ * @param status Le statut renvoyé par wait4
+ * @param ru Les ressources consommées renvoyées par wait4 (NULL : inconnues, mises à zéro)
+ * @return int L'état précédent du job s'il vient de se terminer, -1 si d'autres processus du job tournent encore.
+ */
+int mark_proc_done(proc_t *p, int status, const struct rusage *ru);
+
+/**
+ * @brief Marque les processus suspendus d'un job comme relancés (après SIGCONT par fg ou bg).
+ */
+void mark_job_continued(job_t *j);
+
+/**
+ * @brief sigchld_handler : marque un job actif comme suspendu.
+ * @return int L'état précédent, -1 si le job n'était plus actif.
+ */
+int mark_job_stopped(job_t *j);
+
+/**
+ * @brief sigchld_handler : marque un job actif comme terminé (JOB_DONE) avec son statut, et
+ * l'empile pour qu'il soit retiré de la table au prochain add_job.
+ * Le job reste lisible (jid, pgid, cmdline) jusqu'à son retrait.
+ * @return int L'état précédent, -1 si le job n'était plus actif.
+ */
+int mark_job_done(job_t *j, int status);
+
+
+/**
+ * @brief Affiche la liste des jobs actifs, par jid croissant.
+ * @param long_format Si non nul, détaille chaque étape : pid, état, statut de fin et durée depuis le lancement du job
+ */
+void list_jobs(int long_format);
+
+/**
+ * @brief Compte une paire blocage/déblocage de SIGCHLD (deux appels sigprocmask) qu'un accès à la table
+ * n'a plus à faire : sigchld_handler n'est appelé que par la boucle d'événements, jamais pendant l'accès.
+ */
+void jobs_mask_avoided(void);
 
 /**
- * @brief Affiche la liste des jobs actifs.
+ * @brief Affiche les statistiques de la table : appels sigprocmask évités depuis jobs_init.
  */
-void list_jobs();
+void jobs_print_stats(void);
 
 /**
- * @brief Retourne 1 s'il existe au moins un job en état JOB_RUNNING ou JOB_STOPPED 0 sinon.
+ * @brief Retourne 1 s'il existe au moins un job en état JOB_RUNNING ou JOB_STOPPED 0 sinon (en O(1)).
  */
 int has_running_jobs(void);
 
@@ -140,7 +286,7 @@ int has_running_jobs(void);
  * @brief Retourne une chaîne de caractères représentant l'état du job.
  * 
  * @param state L'état du job à convertir en chaîne
- * @return Chaîne de caractères correspondant à l'état du job ("Foreground", "Running", "Stopped", ou "Unknown").
+ * @return Chaîne de caractères correspondant à l'état du job ("Foreground", "Running", "Stopped", "Done" ou "Unknown").
  */
 const char *job_state_str(job_state_t state);
 
@@ -0,0 +1,47 @@
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+/**
+ * @brief Notifications de changement d'état des jobs (Stopped, Done).
+ *
+ * Par défaut (mode différé, comme bash), les notifications sont mises en file dans un anneau
+ * au moment du changement d'état et écrites d'un seul writev juste avant le prompt suivant :
+ * elles n'apparaissent plus au milieu de la ligne en cours de saisie, et une rafale de fins
+ * de jobs ne coûte qu'un appel système. En mode immédiat (notify on, équivalent de set -b),
+ * l'anneau est vidé à la fin de chaque traitement de SIGCHLD.
+ */
+
+/**
+ * @brief Met en file une notification (format de printf). L'anneau est vidé s'il est plein.
+ * @param fmt Le format, suivi de ses arguments
+ */
+void notify_job(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Écrit les notifications en attente sur la sortie standard, en un seul writev
+ * (après avoir vidé le buffer de stdout, pour respecter l'ordre des sorties).
+ */
+void notify_flush(void);
+
+/**
+ * @brief Fin d'un traitement de SIGCHLD : vide l'anneau en mode immédiat, ne fait rien en mode différé.
+ */
+void notify_end_batch(void);
+
+/**
+ * @brief Choisit le mode de notification.
+ * @param on 1 : immédiat (à chaque SIGCHLD), 0 : différé (avant le prompt)
+ */
+void notify_set_immediate(int on);
+
+/**
+ * @brief Retourne 1 en mode immédiat, 0 en mode différé.
+ */
+int notify_is_immediate(void);
+
+/**
+ * @brief Affiche les statistiques des notifications : nombre de notifications et d'appels à writev.
+ */
+void notify_print_stats(void);
+
+#endif /* NOTIFY_H */
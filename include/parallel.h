@@ -0,0 +1,27 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "readcmd.h"
+
+/**
+ * @brief Commande intégrée parallel : exécute un modèle de commande sur chaque ligne d'entrée,
+ * avec au plus N instances simultanées.
+ *
+ * Usage : parallel [-j N] [-k] [-a fichier] commande [arg ...] [::: arg ...]
+ *   -j N       nombre d'instances simultanées (par défaut : nombre de processeurs)
+ *   -k         restituer les sorties dans l'ordre des entrées
+ *   -a fichier lire les arguments dans fichier
+ *   ::: a b c  arguments donnés directement sur la ligne de commande
+ * Chaque "{}" de la commande est remplacé par l'argument ; sans "{}", l'argument est ajouté à la fin.
+ * Les redirections de la ligne s'appliquent à parallel : "< fichier" ou un here-document fournit les
+ * arguments, "> fichier" reçoit la sortie de toutes les instances. En dernière étape d'une séquence
+ * ("commande | parallel ..."), les arguments sont la sortie des étapes précédentes
+ * (execute_command_sequence la donne comme "< fichier"). L'entrée du shell n'est jamais lue.
+ *
+ * @param cmd La ligne de commande (cmd->seq[0][0] == "parallel")
+ * @return int 0 si toutes les instances ont réussi, 1 sinon (2 en cas d'erreur d'utilisation ou sans
+ * source d'arguments).
+ */
+int builtin_parallel(struct cmdline *cmd);
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,39 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+/**
+ * @brief Cache des chemins résolus dans PATH (équivalent de la table "hash" de bash).
+ *
+ * Chaque nom de commande est associé au chemin absolu trouvé lors de la première
+ * résolution, pour éviter de reparcourir PATH (et de tenter un execve par répertoire)
+ * à chaque lancement. Le cache est vidé automatiquement si la valeur de PATH change.
+ * Un chemin trouvé par une entrée vide ou relative de PATH dépend du répertoire courant : il est
+ * rendu absolu mais jamais mis en cache.
+ */
+
+/**
+ * @brief Retourne le chemin de l'exécutable correspondant à name, en le résolvant dans PATH si besoin.
+ * @param name Le nom de la commande (argv[0])
+ * @return Le chemin de l'exécutable (name lui-même s'il contient un '/'), ou NULL s'il est introuvable.
+ * Un chemin non mis en cache reste valide jusqu'au prochain appel.
+ */
+const char *pathcache_lookup(const char *name);
+
+/**
+ * @brief Oublie l'entrée associée à name (binaire disparu ou déplacé).
+ * @param name Le nom de la commande
+ * @return 0 si l'entrée existait, -1 sinon.
+ */
+int pathcache_forget(const char *name);
+
+/**
+ * @brief Vide entièrement le cache.
+ */
+void pathcache_reset(void);
+
+/**
+ * @brief Affiche le contenu du cache (nombre d'utilisations et chemin de chaque commande).
+ */
+void pathcache_list(void);
+
+#endif /* PATHCACHE_H */
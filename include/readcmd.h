@@ -5,13 +5,34 @@
 #ifndef __READCMD_H
 #define __READCMD_H
 
+#include <stddef.h>
+
 /**
  * @brief Lit une ligne de commande à partir de l'entrée standard et la analyse en une structure cmdline
+ * En attendant l'entrée standard, la boucle d'événements (events_wait) traite les signaux reçus.
  * @return struct cmdline* 
  */
 struct cmdline *readcmd(void);
 
 
+/**
+ * @brief Lit désormais les commandes dans un script plutôt que sur l'entrée standard.
+ * Le script est projeté en mémoire (mmap) et découpé sur place : les mots des cmdline
+ * pointent directement dans la projection, sans copie par ligne.
+ * @param path Le chemin du script
+ * @return int 0 si succès, -1 si le script ne peut pas être ouvert (errno positionné)
+ */
+int readcmd_open_script(const char *path);
+
+/**
+ * @brief Statistiques de l'analyseur. Toute la structure retournée par readcmd() est construite
+ * dans une arène propre à la ligne, libérée en O(1) à l'appel suivant : elle n'est valide que
+ * jusqu'au prochain appel à readcmd().
+ * @param lines Nombre de lignes lues depuis le démarrage
+ * @param mallocs Nombre d'appels à malloc faits par l'arène depuis le démarrage
+ */
+void readcmd_stats(unsigned long *lines, unsigned long *mallocs);
+
 /**
  * @brief Nombre de commandes simples dans une séquence de commandes
  * @param cmd Un pointeur vers une structure cmdline contenant la ligne de commande à analyser
@@ -19,17 +40,37 @@ struct cmdline *readcmd(void);
  */
 int count_simple_commands(struct cmdline *cmd);
 
+/* Substitution de processus <(cmd) ou >(cmd) (champ subst de struct cmdline) */
+struct procsubst {
+	int stage;	/* Indice, dans seq, de l'étape dont un argument est remplacé par /dev/fd/N */
+	char *word;	/* Cet argument ("<(cmd)"), retrouvé par adresse : les préfixes (time...) décalent les mots */
+	int output;	/* 1 pour >(cmd) : la commande principale écrit dans le pipe, 0 pour <(cmd) */
+	char ***seq;	/* Séquence de commandes de la substitution (comme le champ seq) */
+};
+
 /* Structure returned by readcmd() */
 struct cmdline {
 	char *err;	/* If not null, it is an error message that should be
 			   displayed. The other fields are null. */
 	char *in;	/* If not null : name of file for input redirection. */
+	char *in_data;	/* Si non nul : contenu d'un here-document (<<) ou d'une here-string (<<<), à
+			   donner en entrée (exclusif avec in). */
+	size_t in_len;	/* Taille de in_data. */
 	char *out;	/* If not null : name of file for output redirection. */
 	int out_append;	/* If out is not null, out_append is 1 if the redirection is >>, 0 if it is >. */
 	char ***seq;	/* See comment below */
 	int background; /* 1 if the command line ends with &, 0 otherwise. */
+	struct procsubst *subst; /* Substitutions de processus de la ligne, dans l'ordre des arguments. */
+	int nb_subst;	/* Nombre de substitutions de processus. */
+	struct cmdline *next; /* Ligne de commande suivante dans la séquence (;, &&, ||), NULL si aucune. */
+	int next_op;	/* Condition d'exécution de next : SEQ_ALWAYS, SEQ_AND ou SEQ_OR. */
 };
 
+/* Opérateurs de séquencement (champ next_op de struct cmdline) */
+#define SEQ_ALWAYS 0	/* ";" ou "&" : la ligne suivante est toujours exécutée */
+#define SEQ_AND    1	/* "&&" : la ligne suivante est exécutée si celle-ci a réussi (statut 0) */
+#define SEQ_OR     2	/* "||" : la ligne suivante est exécutée si celle-ci a échoué */
+
 /* Field seq of struct cmdline :
 A command line is a sequence of commands whose output is linked to the input
 of the next command by a pipe. To describe such a structure :
@@ -37,5 +78,12 @@ A command is an array of strings (char **), whose last item is a null pointer.
 A sequence is an array of commands (char ***), whose last item is a null
 pointer.
 When a struct cmdline is returned by readcmd(), seq[0] is never null.
+
+Field next of struct cmdline :
+A line such as "a ; b && c || d" is returned as a list of struct cmdline
+linked by next, each one being a pipeline with its own redirections and
+background flag. next_op tells how the execution of next depends on the
+exit status of the current one. The err field is only set on the first
+element of the list.
 */
 #endif
@@ -0,0 +1,44 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+/**
+ * @brief Recherche vectorisée des délimiteurs de mots de la ligne de commande.
+ *
+ * Un délimiteur est l'un des caractères ' ', '\t', '<', '>', '|', '&', ';' ou le '\0' de fin de ligne.
+ * L'implémentation scalaire sert de référence ; sur x86-64, la version SSE2 traite 16 octets à la fois
+ * et la version AVX2 32 octets, choisie à l'exécution si le processeur la supporte.
+ * Les versions vectorielles ne lisent que des blocs alignés : elles ne débordent jamais sur une page
+ * qui ne contient pas la chaîne.
+ */
+
+/* Implémentations disponibles (scan_select) */
+#define SCAN_SCALAR 0
+#define SCAN_SSE2   1
+#define SCAN_AVX2   2
+
+/**
+ * @brief Retourne le premier délimiteur à partir de s, avec la meilleure implémentation disponible.
+ * @param s La chaîne à parcourir (terminée par '\0')
+ * @return char* Un pointeur vers le premier délimiteur (au pire, le '\0' final)
+ */
+char *scan_delimiter(const char *s);
+
+/**
+ * @brief Implémentation scalaire de référence de scan_delimiter (un octet à la fois).
+ */
+char *scan_delimiter_scalar(const char *s);
+
+/**
+ * @brief Impose l'implémentation utilisée par scan_delimiter (tests et bancs d'essai).
+ * @param impl SCAN_SCALAR, SCAN_SSE2 ou SCAN_AVX2
+ * @return int 0 si succès, -1 si l'implémentation n'est pas disponible sur ce processeur
+ */
+int scan_select(int impl);
+
+/**
+ * @brief Meilleure implémentation disponible sur ce processeur.
+ * @return int SCAN_SCALAR, SCAN_SSE2 ou SCAN_AVX2
+ */
+int scan_best(void);
+
+#endif /* SCAN_H */
@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Traces internes du shell, activables à l'exécution (commande trace).
+ *
+ * Les points de trace sont toujours compilés : désactivés, ils ne coûtent qu'un test de trace_enabled.
+ * Activés, chaque événement (horodatage CLOCK_MONOTONIC en nanosecondes et deux arguments entiers)
+ * est écrit dans un anneau binaire propre au processus (un fils créé par fork en hérite une copie,
+ * perdue à l'exec) : les plus anciens sont écrasés quand l'anneau est plein. trace_dump exporte
+ * l'anneau au format JSON des traces Chrome (chrome://tracing, Perfetto).
+ */
+
+/**
+ * @brief Événements tracés. Les paires _BEGIN/_END délimitent une durée, les autres sont ponctuels.
+ */
+typedef enum {
+    TRACE_READCMD_BEGIN,  /* Début de la lecture d'une ligne (readcmd) */
+    TRACE_READCMD_END,    /* Ligne lue et analysée */
+    TRACE_EXECUTE_BEGIN,  /* Début de execute_command_line */
+    TRACE_EXECUTE_END,    /* Fin de execute_command_line (a : code de retour) */
+    TRACE_SPAWN_BEGIN,    /* posix_spawn d'une étape */
+    TRACE_SPAWN_END,      /* Retour de posix_spawn, après l'exec (a : pid, -1 si échec) */
+    TRACE_FORK,           /* Fork d'une étape (repli ou commande intégrée d'étape) (a : pid) */
+    TRACE_SETPGID,        /* setpgid dans le shell (a : pid, b : pgid) */
+    TRACE_TCSETPGRP,      /* Terminal donné à un groupe (a : pgid) */
+    TRACE_SIGCHLD,        /* Enfant récolté par sigchld_handler (a : pid, b : statut) */
+    TRACE_JOB_ADD,        /* Job ajouté à la table (a : jid, b : pgid) */
+    TRACE_JOB_DELETE,     /* Job retiré de la table (a : jid, b : pgid) */
+    TRACE_NB_EVENTS
+} trace_event_t;
+
+extern int trace_enabled;
+
+/**
+ * @brief Point de trace : enregistre l'événement ev avec ses arguments a et b si les traces sont activées.
+ */
+#define TRACE(ev, a, b)                                   \
+    do {                                                  \
+        if (__builtin_expect(trace_enabled, 0))           \
+            trace_record((ev), (int64_t)(a), (int64_t)(b)); \
+    } while (0)
+
+/**
+ * @brief Enregistre un événement dans l'anneau (utiliser la macro TRACE).
+ */
+void trace_record(trace_event_t ev, int64_t a, int64_t b);
+
+/**
+ * @brief Active (en allouant l'anneau au premier appel) ou désactive les traces. Les événements
+ * déjà enregistrés sont conservés.
+ * @param on 1 pour activer, 0 pour désactiver
+ */
+void trace_set_enabled(int on);
+
+/**
+ * @brief Vide l'anneau.
+ */
+void trace_clear(void);
+
+/**
+ * @brief Écrit les événements de l'anneau, du plus ancien au plus récent, au format JSON des traces Chrome.
+ * @param out Le fichier de sortie
+ * @return int Le nombre d'événements écrits
+ */
+int trace_dump(FILE *out);
+
+/**
+ * @brief Affiche l'état des traces : activées ou non, nombre d'événements enregistrés et écrasés.
+ */
+void trace_print_status(void);
+
+#endif /* TRACE_H */
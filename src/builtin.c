@@ -1,9 +1,134 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "builtin.h"
+#include "events.h"
 #include "execute.h"
 #include "jobs.h"
+#include "notify.h"
+#include "pathcache.h"
+#include "trace.h"
+#include "parallel.h"
+
+/**
+ * @brief Commande wait [-n] [-t secondes] [%N | pid ...].
+ * Sans job désigné, attend tous les jobs en arrière-plan (lancés ou suspendus) ; avec -n, seulement
+ * le premier d'entre eux qui se termine. L'attente dort (poll) sur les pidfd des processus attendus,
+ * les signaux et le minuteur de -t : aucune boucle active, quel que soit le nombre de jobs.
+ * @param args La commande (args[0] == "wait")
+ * @return int Le code de retour du dernier job désigné (avec -n : du premier job terminé, sans job
+ * désigné : 0), 124 si le délai -t expire avant, 127 si un job désigné est inconnu (ou, avec -n, s'il
+ * n'y a rien à attendre), 2 en cas d'erreur d'utilisation.
+ */
+static int builtin_wait(char **args) {
+    int any = 0;
+    double timeout = -1;
+    int i = 1;
+
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        if (strcmp(args[i], "-n") == 0) {
+            any = 1;
+        } else if (strcmp(args[i], "-t") == 0 && args[i + 1] != NULL) {
+            char *end;
+            timeout = strtod(args[++i], &end);
+            if (end == args[i] || *end != '\0' || timeout < 0) {
+                fprintf(stderr, "wait: délai invalide: %s\n", args[i]);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "usage: wait [-n] [-t secondes] [%%N | pid ...]\n");
+            return 2;
+        }
+    }
+
+    // Jobs attendus : ceux désignés, sinon tous les jobs en arrière-plan
+    jobs_mask_avoided();
+    int status = 0;
+    int designated = args[i] != NULL;
+    int nb_targets = 0, capacity = 0, nb_procs = 0;
+    job_t **targets = NULL;
+    if (designated) {
+        for (; args[i] != NULL; i++) {
+            job_t *j = resolve_job_arg(args[i]);
+            if (j == NULL || !(JOB_MASK(j->state) & (JOB_MASK(JOB_RUNNING) | JOB_MASK(JOB_STOPPED)))) {
+                fprintf(stderr, "wait: job not found: %s\n", args[i]);
+                status = 127;
+                continue;
+            }
+            if (nb_targets == capacity) {
+                capacity = capacity ? 2 * capacity : 8;
+                targets = Realloc(targets, capacity * sizeof(job_t *));
+            }
+            targets[nb_targets++] = j;
+            nb_procs += j->nb_procs;
+        }
+    } else {
+        for (job_t *j = get_next_job(NULL); j != NULL; j = get_next_job(j)) {
+            if (j->state != JOB_RUNNING && j->state != JOB_STOPPED)
+                continue;
+            if (nb_targets == capacity) {
+                capacity = capacity ? 2 * capacity : 8;
+                targets = Realloc(targets, capacity * sizeof(job_t *));
+            }
+            targets[nb_targets++] = j;
+            nb_procs += j->nb_procs;
+        }
+    }
+    if (nb_targets == 0) {
+        free(targets);
+        return any ? 127 : status;
+    }
+
+    if (timeout >= 0) {
+        struct timespec delay;
+        delay.tv_sec = (time_t)timeout;
+        delay.tv_nsec = (long)((timeout - delay.tv_sec) * 1e9);
+        events_set_timer(&delay);
+    }
+
+    // Les jobs terminés restent lisibles (JOB_DONE) : rien ne les retire de la table pendant l'attente
+    int *fds = Malloc((nb_procs > 0 ? nb_procs : 1) * sizeof(int));
+    int timed_out = 0;
+    for (;;) {
+        int nb_done = 0, nb_fds = 0;
+        job_t *finished = NULL;
+        for (int k = 0; k < nb_targets; k++) {
+            if (targets[k]->state == JOB_DONE) {
+                nb_done++;
+                if (finished == NULL)
+                    finished = targets[k];
+            } else {
+                nb_fds += job_pidfds(targets[k], fds + nb_fds);
+            }
+        }
+        if (any && finished != NULL) {
+            status = exit_code_of(finished->status);
+            break;
+        }
+        if (nb_done == nb_targets) {
+            if (designated && status == 0)
+                status = exit_code_of(targets[nb_targets - 1]->status);
+            break;
+        }
+        if (timed_out) {
+            status = 124;
+            break;
+        }
+
+        int ev = events_poll(fds, nb_fds);
+        if (ev & EVENT_INPUT) // pidfd lisible : récolter sans attendre le traitement de SIGCHLD
+            sigchld_handler(SIGCHLD);
+        if (ev & EVENT_TIMER)
+            timed_out = 1;
+    }
+
+    if (timeout >= 0)
+        events_set_timer(NULL);
+    free(fds);
+    free(targets);
+    return status;
+}
 
 int execute_builtin(struct cmdline *cmd) {
     if (cmd->seq == NULL || cmd->seq[0] == NULL || cmd->seq[0][0] == NULL) {
@@ -17,51 +142,96 @@ int execute_builtin(struct cmdline *cmd) {
         return 1; // renvoyer 1 pour indiquer une erreur si la terminaison du shell échoue
     }
 
-    // commande jobs
+    // commande jobs [-l | --stats]
     if (strcmp(command, "jobs") == 0) {
-        list_jobs();
+        char *opt = cmd->seq[0][1];
+        if (opt != NULL && strcmp(opt, "--stats") == 0) {
+            jobs_print_stats(); // appels sigprocmask évités
+            events_print_stats(); // réveils de la boucle d'événements et signaux traités
+            notify_print_stats();
+        } else {
+            jobs_mask_avoided();
+            list_jobs(opt != NULL && strcmp(opt, "-l") == 0); // -l : détail de chaque étape
+        }
+        return 0;
+    }
+
+    // commande trace [on | off | clear | dump [fichier]] : traces internes au format Chrome
+    if (strcmp(command, "trace") == 0) {
+        char **args = cmd->seq[0];
+        if (args[1] == NULL) {
+            trace_print_status();
+        } else if (strcmp(args[1], "on") == 0 || strcmp(args[1], "off") == 0) {
+            trace_set_enabled(strcmp(args[1], "on") == 0);
+        } else if (strcmp(args[1], "clear") == 0) {
+            trace_clear();
+        } else if (strcmp(args[1], "dump") == 0) {
+            FILE *out = args[2] != NULL ? fopen(args[2], "we") : stdout;
+            if (out == NULL) {
+                perror(args[2]);
+                return 1;
+            }
+            int nb = trace_dump(out);
+            if (out != stdout) {
+                fclose(out);
+                printf("trace: %d événements écrits dans %s\n", nb, args[2]);
+            }
+            fflush(stdout);
+        } else {
+            fprintf(stderr, "usage: trace [on | off | clear | dump [fichier]]\n");
+            return 2;
+        }
         return 0;
     }
 
+    // commande notify [on | off] : notifications immédiates ou différées jusqu'au prompt
+    if (strcmp(command, "notify") == 0) {
+        char *arg = cmd->seq[0][1];
+        if (arg == NULL) {
+            printf("notify: %s\n", notify_is_immediate() ? "on (immédiat)" : "off (différé jusqu'au prompt)");
+        } else if (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0) {
+            notify_set_immediate(strcmp(arg, "on") == 0);
+        } else {
+            fprintf(stderr, "usage: notify [on | off]\n");
+            return 2;
+        }
+        return 0;
+    }
+
+    /*
+     * fg, bg, stop et wait consultent la table sans précaution : elle n'est modifiée que par le shell
+     * lui-même (sigchld_handler n'est appelé que par la boucle d'événements ou par wait). Une transition
+     * d'état échoue simplement si le job s'est déjà terminé. Les signaux passent par job_signal (pidfd) :
+     * jamais de kill sur un pid qui aurait pu être réattribué. Chaque accès compte la paire de
+     * sigprocmask qu'il faisait avant la boucle d'événements (jobs --stats).
+     */
+
     // commande fg [%N | PID]
     if (strcmp(command, "fg") == 0) {
         char *arg = cmd->seq[0][1]; // recupérer l'argument optionnel
         job_t *j;
 
-        // Bloquer SIGCHLD pendant la manipulation de la table de jobs
-        sigset_t old_mask;
-        jobs_block_sigchld(&old_mask);
+        jobs_mask_avoided();
 
         if (arg == NULL) {
-            // si sans argument : prendre le dernier job stoppé ou en background
-            j = NULL;
-            
-            // Prendre le job avec le plus grand jid qui n'est pas au foreground
-            for (int i = 0; i < MAXJOBS; i++) {
-                job_t *cand = get_job_by_jid(i + 1);
-                if (cand && cand->state != JOB_FOREGROUND)
-                    j = cand;
-            }
+            // si sans argument : prendre le job avec le plus grand jid qui n'est pas au foreground
+            j = get_current_job();
         } else { // Un argument est fourni soit un job id soit un pgid
             j = resolve_job_arg(arg);
         }
 
-        if (j == NULL) {
+        if (j == NULL || job_transition(j, JOB_MASK(JOB_RUNNING) | JOB_MASK(JOB_STOPPED), JOB_FOREGROUND) < 0) {
             fprintf(stderr, "fg: job not found\n");
-            jobs_unblock_sigchld(&old_mask);
             return 1;
         }
 
         pid_t pgid = j->pgid;
         printf("%s\n", j->cmdline);
         fflush(stdout); // S'assurer que la ligne de commande est affichée avant de continuer
-        j->state = JOB_FOREGROUND;
-        kill(-pgid, SIGCONT); // Envoyer SIGCONT à tous les processus du groupe pour les faire passer au foreground
-
-        jobs_unblock_sigchld(&old_mask);
+        mark_job_continued(j);
+        job_signal(j, SIGCONT); // Envoyer SIGCONT à tous les processus du groupe pour les faire passer au foreground
 
-        wait_for_fg_job(pgid);
-        return 0;
+        return wait_for_fg_job(pgid);
     }
 
     // bg [%N | PID]
@@ -72,23 +242,17 @@ int execute_builtin(struct cmdline *cmd) {
             return 1;
         }
 
-        sigset_t old_mask;
-        jobs_block_sigchld(&old_mask);
-
+        jobs_mask_avoided();
         job_t *j = resolve_job_arg(arg);
-        if (j == NULL) {
+        if (j == NULL || job_transition(j, JOB_MASK(JOB_RUNNING) | JOB_MASK(JOB_STOPPED), JOB_RUNNING) < 0) {
             fprintf(stderr, "bg: job not found: %s\n", arg);
-            jobs_unblock_sigchld(&old_mask);
             return 1;
         }
 
-        j->state = JOB_RUNNING;
-        pid_t pgid = j->pgid;
-        printf("[%d] %d %s\n", j->jid, (int)pgid, j->cmdline);
+        printf("[%d] %d %s\n", j->jid, (int)j->pgid, j->cmdline);
         fflush(stdout);
-        kill(-pgid, SIGCONT);
-
-        jobs_unblock_sigchld(&old_mask);
+        mark_job_continued(j);
+        job_signal(j, SIGCONT);
         return 0;
     }
 
@@ -100,34 +264,433 @@ int execute_builtin(struct cmdline *cmd) {
             return 1;
         }
 
-        sigset_t old_mask;
-        jobs_block_sigchld(&old_mask);
-
+        jobs_mask_avoided();
         job_t *j = resolve_job_arg(arg);
         if (j == NULL) {
             fprintf(stderr, "stop: job not found: %s\n", arg);
-            jobs_unblock_sigchld(&old_mask);
             return 1;
         }
 
-        pid_t pgid = j->pgid;
         // Envoyer SIGSTOP à tous les processus du groupe pour les suspendre
-        kill(-pgid, SIGSTOP);
-
-        jobs_unblock_sigchld(&old_mask);
+        job_signal(j, SIGSTOP);
         return 0;
     }
 
-    // wait
+    // wait [-n] [-t secondes] [%N | pid ...]
     if (strcmp(command, "wait") == 0) {
-        sigset_t old_mask;
-        jobs_block_sigchld(&old_mask);
-        while (has_running_jobs()) { // Tant qu'il y a des jobs en cours d'exécution ou stoppés, attendre les changements d'état
-            Sigsuspend(&old_mask);
+        return builtin_wait(cmd->seq[0]);
+    }
+
+    // parallel [-j N] [-k] [-a fichier] commande [arg ...] [::: arg ...]
+    if (strcmp(command, "parallel") == 0) {
+        return builtin_parallel(cmd);
+    }
+
+    // pipesize [taille[k|m]]
+    if (strcmp(command, "pipesize") == 0) {
+        char *arg = cmd->seq[0][1];
+        if (arg == NULL) {
+            if (get_pipe_buffer_size() == 0)
+                printf("pipesize: taille par défaut du noyau\n");
+            else
+                printf("pipesize: %d\n", get_pipe_buffer_size());
+            return 0;
         }
-        jobs_unblock_sigchld(&old_mask);
+
+        char *end;
+        long unit = 1;
+        errno = 0;
+        long size = strtol(arg, &end, 10);
+        if (*end == 'k' || *end == 'K') {
+            unit = 1024;
+            end++;
+        } else if (*end == 'm' || *end == 'M') {
+            unit = 1024 * 1024;
+            end++;
+        }
+        // Dépassement vérifié avant la multiplication
+        if (end == arg || *end != '\0' || size < 0 || errno == ERANGE || size > LONG_MAX / unit) {
+            fprintf(stderr, "pipesize: taille invalide: %s\n", arg);
+            return 1;
+        }
+        size *= unit;
+        int effective = set_pipe_buffer_size(size);
+        if (effective != size)
+            printf("pipesize: limité à %d (pipe-max-size)\n", effective);
         return 0;
     }
 
+    // hash [-r] [-d nom] [nom ...]
+    if (strcmp(command, "hash") == 0) {
+        char **args = cmd->seq[0];
+        int status = 0;
+
+        if (args[1] == NULL) { // sans argument : afficher le cache
+            pathcache_list();
+            return 0;
+        }
+        for (int i = 1; args[i] != NULL; i++) {
+            if (strcmp(args[i], "-r") == 0) { // vider le cache
+                pathcache_reset();
+            } else if (strcmp(args[i], "-d") == 0) { // oublier une commande
+                if (args[i + 1] == NULL) {
+                    fprintf(stderr, "hash: -d: argument manquant\n");
+                    return 1;
+                }
+                i++;
+                if (pathcache_forget(args[i]) < 0) {
+                    fprintf(stderr, "hash: %s: not found\n", args[i]);
+                    status = 1;
+                }
+            } else if (pathcache_lookup(args[i]) == NULL) { // résoudre et mémoriser
+                fprintf(stderr, "hash: %s: not found\n", args[i]);
+                status = 1;
+            }
+        }
+        return status;
+    }
+
     return -1; // Pas un builtin
-}
\ No newline at end of file
+}
+
+
+/* Commandes intégrées utilisables comme étapes d'une séquence */
+
+/**
+ * @brief Écrit entièrement buf sur fd (gère les écritures partielles).
+ * @return 0 si succès, -1 en cas d'erreur d'écriture.
+ */
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int stage_true(char **argv, int fd_in, int fd_out) {
+    return 0;
+}
+
+static int stage_false(char **argv, int fd_in, int fd_out) {
+    return 1;
+}
+
+// echo [-n] [mot ...]
+static int stage_echo(char **argv, int fd_in, int fd_out) {
+    int newline = 1;
+    int i = 1;
+    if (argv[i] != NULL && strcmp(argv[i], "-n") == 0) {
+        newline = 0;
+        i++;
+    }
+
+    size_t len = 1;
+    for (int j = i; argv[j] != NULL; j++)
+        len += strlen(argv[j]) + 1;
+
+    char *buf = Malloc(len);
+    char *p = buf;
+    for (int j = i; argv[j] != NULL; j++) {
+        if (j > i)
+            *p++ = ' ';
+        size_t l = strlen(argv[j]);
+        memcpy(p, argv[j], l);
+        p += l;
+    }
+    if (newline)
+        *p++ = '\n';
+
+    int status = write_all(fd_out, buf, p - buf) < 0 ? 1 : 0;
+    Free(buf);
+    return status;
+}
+
+/**
+ * @brief Interprète une séquence d'échappement (\n, \t, \\, ...) du format de printf.
+ * @param f Pointeur sur le caractère qui suit le '\\', avancé après la séquence
+ * @param out Flux où écrire le caractère correspondant
+ */
+static void printf_escape(const char **f, FILE *out) {
+    char c = **f;
+    switch (c) {
+        case 'n': fputc('\n', out); break;
+        case 't': fputc('\t', out); break;
+        case 'r': fputc('\r', out); break;
+        case 'a': fputc('\a', out); break;
+        case 'b': fputc('\b', out); break;
+        case 'f': fputc('\f', out); break;
+        case 'v': fputc('\v', out); break;
+        case '\\': fputc('\\', out); break;
+        case '\0': fputc('\\', out); return;
+        default: fputc('\\', out); fputc(c, out); break;
+    }
+    (*f)++;
+}
+
+// printf format [argument ...] : %s %b %c %d %i %u %o %x %X %f %e %g %% avec drapeaux, largeur et précision
+static int stage_printf(char **argv, int fd_in, int fd_out) {
+    if (argv[1] == NULL) {
+        fprintf(stderr, "printf: usage: printf format [arguments]\n");
+        return 2;
+    }
+
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&buf, &len);
+    if (out == NULL) {
+        perror("printf");
+        return 1;
+    }
+
+    char **args = argv + 2;
+    int status = 0;
+    // Le format est réutilisé tant qu'il reste des arguments (comme le printf de bash)
+    do {
+        char **args_start = args;
+        for (const char *f = argv[1]; *f != '\0'; ) {
+            if (*f == '\\') {
+                f++;
+                printf_escape(&f, out);
+                continue;
+            }
+            if (*f != '%') {
+                fputc(*f++, out);
+                continue;
+            }
+            if (f[1] == '%') {
+                fputc('%', out);
+                f += 2;
+                continue;
+            }
+
+            // Spécification de conversion : %[drapeaux][largeur][.précision]conversion
+            char spec[32];
+            size_t n = strspn(f + 1, "-+ #0123456789.") + 1;
+            if (n + 4 > sizeof(spec) || f[n] == '\0') { // place pour "ll", la conversion et le '\0'
+                fputs(f, out);
+                break;
+            }
+            char conv = f[n];
+            const char *arg = *args ? *args++ : NULL;
+            memcpy(spec, f, n);
+            f += n + 1;
+
+            switch (conv) {
+                case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': {
+                    char *end;
+                    long long v = arg ? strtoll(arg, &end, 0) : 0;
+                    if (arg && (*end != '\0' || end == arg)) {
+                        fprintf(stderr, "printf: %s: invalid number\n", arg);
+                        status = 1;
+                    }
+                    memcpy(spec + n, "ll", 2);
+                    spec[n + 2] = conv;
+                    spec[n + 3] = '\0';
+                    fprintf(out, spec, v);
+                    break;
+                }
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+                    char *end;
+                    double v = arg ? strtod(arg, &end) : 0.0;
+                    if (arg && (*end != '\0' || end == arg)) {
+                        fprintf(stderr, "printf: %s: invalid number\n", arg);
+                        status = 1;
+                    }
+                    spec[n] = conv;
+                    spec[n + 1] = '\0';
+                    fprintf(out, spec, v);
+                    break;
+                }
+                case 'c':
+                    spec[n] = 'c';
+                    spec[n + 1] = '\0';
+                    fprintf(out, spec, arg ? arg[0] : '\0');
+                    break;
+                case 'b': // chaîne avec interprétation des échappements
+                    for (const char *a = arg ? arg : ""; *a != '\0'; ) {
+                        if (*a == '\\') {
+                            a++;
+                            printf_escape(&a, out);
+                        } else {
+                            fputc(*a++, out);
+                        }
+                    }
+                    break;
+                case 's':
+                default:
+                    spec[n] = 's';
+                    spec[n + 1] = '\0';
+                    fprintf(out, spec, arg ? arg : "");
+                    break;
+            }
+        }
+        if (args == args_start) // format sans conversion : ne pas boucler
+            break;
+    } while (*args != NULL);
+
+    fclose(out);
+    if (write_all(fd_out, buf, len) < 0)
+        status = 1;
+    free(buf);
+    return status;
+}
+
+// cat [fichier | - ...]
+static int stage_cat(char **argv, int fd_in, int fd_out) {
+    char buf[MAXBUF];
+    struct stat st_out;
+    int out_is_reg = fstat(fd_out, &st_out) == 0 && S_ISREG(st_out.st_mode);
+    int status = 0;
+    int i = 1;
+
+    do {
+        const char *name = argv[i];
+        int fd = fd_in;
+        if (name != NULL && strcmp(name, "-") != 0) {
+            fd = open(name, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                fprintf(stderr, "cat: %s: %s\n", name, strerror(errno));
+                status = 1;
+                continue;
+            }
+        }
+
+        // Sortie identique à l'entrée (cat f >> f) : la copie relirait sans fin ce qu'elle ajoute
+        struct stat st;
+        if (out_is_reg && fstat(fd, &st) == 0 && st.st_dev == st_out.st_dev && st.st_ino == st_out.st_ino
+            && lseek(fd, 0, SEEK_CUR) < st.st_size) {
+            fprintf(stderr, "cat: %s: input file is output file\n", name ? name : "-");
+            status = 1;
+            if (fd != fd_in)
+                close(fd);
+            continue;
+        }
+
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            // Dans le shell (gros fichier ordinaire), Ctrl+C reste en attente : arrêter la copie
+            if (events_interrupt_pending()) {
+                if (fd != fd_in)
+                    close(fd);
+                return 130;
+            }
+            if (write_all(fd_out, buf, n) < 0) {
+                perror("cat: write");
+                status = 1;
+                break;
+            }
+        }
+        if (n < 0) {
+            fprintf(stderr, "cat: %s: %s\n", name ? name : "-", strerror(errno));
+            status = 1;
+        }
+        if (fd != fd_in)
+            close(fd);
+    } while (argv[i] != NULL && argv[++i] != NULL);
+
+    return status;
+}
+
+// tee [-a] [fichier ...]
+static int stage_tee(char **argv, int fd_in, int fd_out) {
+    char buf[MAXBUF];
+    int append = argv[1] != NULL && strcmp(argv[1], "-a") == 0;
+    int first = 1 + append;
+    int nb_files = 0;
+    int status = 0;
+
+    for (int i = first; argv[i] != NULL; i++)
+        nb_files++;
+    int *fds = Malloc((nb_files + 1) * sizeof(int));
+    for (int i = 0; i < nb_files; i++) {
+        fds[i] = open(argv[first + i], O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+        if (fds[i] < 0) {
+            fprintf(stderr, "tee: %s: %s\n", argv[first + i], strerror(errno));
+            status = 1;
+        }
+    }
+
+    ssize_t n;
+    while ((n = read(fd_in, buf, sizeof(buf))) > 0) {
+        if (fd_out >= 0 && write_all(fd_out, buf, n) < 0) {
+            perror("tee: write");
+            status = 1;
+            fd_out = -1; // continuer vers les fichiers
+        }
+        for (int i = 0; i < nb_files; i++) {
+            if (fds[i] >= 0 && write_all(fds[i], buf, n) < 0) {
+                fprintf(stderr, "tee: %s: %s\n", argv[first + i], strerror(errno));
+                status = 1;
+                close(fds[i]);
+                fds[i] = -1;
+            }
+        }
+    }
+    if (n < 0) {
+        perror("tee: read");
+        status = 1;
+    }
+    for (int i = 0; i < nb_files; i++)
+        if (fds[i] >= 0)
+            close(fds[i]);
+    free(fds);
+    return status;
+}
+
+/**
+ * @brief Table des commandes intégrées d'étape.
+ * reads_stdin : 1 si la commande lit son entrée standard (sans argument ou avec "-"), 2 si elle la
+ * lit toujours (jamais exécutée dans le shell).
+ * options : options reconnues par la version intégrée ; toute autre option ("-x") renvoie vers
+ * la commande externe. NULL si la commande n'accepte aucune option.
+ */
+static const struct {
+    const char      *name;
+    stage_builtin_t  func;
+    int              reads_stdin;
+    const char      *options;
+} stage_builtins[] = {
+    { "echo",   stage_echo,   0, "-n" },
+    { "true",   stage_true,   0, NULL },
+    { "false",  stage_false,  0, NULL },
+    { "printf", stage_printf, 0, NULL },
+    { "cat",    stage_cat,    1, NULL },
+    { "tee",    stage_tee,    2, "-a" },
+};
+
+stage_builtin_t find_stage_builtin(char **argv, int in_shell) {
+    if (argv == NULL || argv[0] == NULL)
+        return NULL;
+    for (size_t i = 0; i < sizeof(stage_builtins) / sizeof(stage_builtins[0]); i++) {
+        if (strcmp(argv[0], stage_builtins[i].name) != 0)
+            continue;
+
+        // Option non gérée par la version intégrée : utiliser la commande externe
+        if (argv[1] != NULL && argv[1][0] == '-' && argv[1][1] != '\0'
+            && (stage_builtins[i].options == NULL || strcmp(argv[1], stage_builtins[i].options) != 0))
+            return NULL;
+
+        // Dans le shell, ne pas bloquer sur une lecture de l'entrée standard
+        if (in_shell && stage_builtins[i].reads_stdin == 2)
+            return NULL;
+        if (in_shell && stage_builtins[i].reads_stdin) {
+            if (argv[1] == NULL)
+                return NULL;
+            // Fichiers ordinaires seulement (un fichier absent est signalé par la commande intégrée)
+            for (int j = 1; argv[j] != NULL; j++) {
+                struct stat st;
+                if (strcmp(argv[j], "-") == 0 || (stat(argv[j], &st) == 0 && !S_ISREG(st.st_mode)))
+                    return NULL;
+            }
+        }
+        return stage_builtins[i].func;
+    }
+    return NULL;
+}
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include "csapp.h"
+#include "cache.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+#define CACHE_MAGIC 0x31434853u /* "SHC1" */
+
+/**
+ * @brief En-tête d'une entrée, suivi de la sortie standard de la commande.
+ */
+typedef struct {
+    uint32_t magic;
+    int32_t  status;
+} entry_header_t;
+
+/* Variables d'environnement qui changent la sortie des commandes usuelles */
+static const char *hashed_env[] = { "PATH", "LANG", "LC_ALL", "LC_COLLATE", "LC_CTYPE", "TZ" };
+
+static char *cache_dir = NULL;
+static unsigned long nb_hits = 0, nb_misses = 0;
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+/**
+ * @brief Ajoute une chaîne au hachage, '\0' compris (séparateur : "ab" "c" et "a" "bc" diffèrent).
+ */
+static uint64_t fnv1a_str(uint64_t h, const char *s) {
+    return fnv1a(h, s, strlen(s) + 1);
+}
+
+/**
+ * @brief Répertoire du cache, créé au premier appel.
+ * @return const char* Le chemin, NULL si ni XDG_CACHE_HOME ni HOME ne sont définis ou s'il ne peut pas être créé
+ */
+static const char *get_cache_dir(void) {
+    if (cache_dir != NULL)
+        return cache_dir;
+
+    const char *base = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+    char parent[PATH_MAX];
+    if (base != NULL && base[0] == '/')
+        snprintf(parent, sizeof(parent), "%s", base);
+    else if (home != NULL)
+        snprintf(parent, sizeof(parent), "%s/.cache", home);
+    else
+        return NULL;
+
+    char *dir = Malloc(strlen(parent) + sizeof("/shell"));
+    sprintf(dir, "%s/shell", parent);
+    if ((mkdir(parent, 0700) < 0 && errno != EEXIST) || (mkdir(dir, 0700) < 0 && errno != EEXIST)) {
+        perror(dir);
+        free(dir);
+        return NULL;
+    }
+    cache_dir = dir;
+    return cache_dir;
+}
+
+/**
+ * @brief Chemin de l'entrée key dans buf.
+ */
+static int entry_path(uint64_t key, char *buf, size_t size) {
+    const char *dir = get_cache_dir();
+    if (dir == NULL)
+        return -1;
+    snprintf(buf, size, "%s/%016llx", dir, (unsigned long long)key);
+    return 0;
+}
+
+int cache_key(struct cmdline *c, uint64_t *key) {
+    uint64_t h = FNV_OFFSET;
+    char cwd[PATH_MAX];
+
+    for (int i = 0; c->seq[i] != NULL; i++) {
+        for (int j = 0; c->seq[i][j] != NULL; j++)
+            h = fnv1a_str(h, c->seq[i][j]);
+        h = fnv1a(h, "|", 1); // fin d'étape
+    }
+
+    if (c->in != NULL) {
+        struct stat st;
+        if (stat(c->in, &st) < 0)
+            return -1;
+        int64_t id[5] = { st.st_dev, st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec };
+        h = fnv1a_str(h, c->in);
+        h = fnv1a(h, id, sizeof(id));
+    } else if (c->in_data != NULL) {
+        h = fnv1a(h, "<<", 2);
+        h = fnv1a(h, c->in_data, c->in_len);
+    }
+
+    h = fnv1a_str(h, getcwd(cwd, sizeof(cwd)) != NULL ? cwd : "");
+    for (size_t i = 0; i < sizeof(hashed_env) / sizeof(hashed_env[0]); i++) {
+        const char *v = getenv(hashed_env[i]);
+        h = fnv1a_str(h, hashed_env[i]);
+        h = v != NULL ? fnv1a_str(h, v) : fnv1a(h, "", 0); // variable absente ≠ variable vide
+    }
+    *key = h;
+    return 0;
+}
+
+int cache_open(uint64_t key, long ttl, int *status) {
+    char path[PATH_MAX];
+    entry_header_t header;
+    struct timespec now;
+    struct stat st;
+
+    if (entry_path(key, path, sizeof(path)) < 0) {
+        nb_misses++;
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    // Âge à la nanoseconde près : --ttl 1 refuse une entrée de 1,5 s
+    if (fd >= 0 && fstat(fd, &st) == 0
+        && (ttl < 0 || (now.tv_sec - st.st_mtim.tv_sec) + (now.tv_nsec - st.st_mtim.tv_nsec) * 1e-9 <= ttl)
+        && read(fd, &header, sizeof(header)) == sizeof(header) && header.magic == CACHE_MAGIC) {
+        nb_hits++;
+        *status = header.status;
+        return fd;
+    }
+    if (fd >= 0) {
+        // Entrée périmée ou invalide : supprimée plutôt que gardée indéfiniment
+        close(fd);
+        unlink(path);
+    }
+    nb_misses++;
+    return -1;
+}
+
+char *cache_begin(void) {
+    const char *dir = get_cache_dir();
+    if (dir == NULL)
+        return NULL;
+
+    char *tmp = Malloc(strlen(dir) + sizeof("/.tmpXXXXXX"));
+    sprintf(tmp, "%s/.tmpXXXXXX", dir);
+    int fd = mkostemp(tmp, O_CLOEXEC);
+    if (fd < 0) {
+        perror(tmp);
+        free(tmp);
+        return NULL;
+    }
+    // En-tête provisoire (magic nul : entrée invalide), complété par cache_commit
+    entry_header_t header = { 0, 0 };
+    int ok = write(fd, &header, sizeof(header)) == sizeof(header);
+    close(fd);
+    if (!ok) {
+        cache_abort(tmp);
+        return NULL;
+    }
+    return tmp;
+}
+
+int cache_commit(char *tmp, uint64_t key, int status) {
+    char path[PATH_MAX];
+    entry_header_t header = { CACHE_MAGIC, status };
+
+    int fd = open(tmp, O_WRONLY | O_CLOEXEC);
+    int ok = fd >= 0 && pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+    if (fd >= 0)
+        close(fd);
+    if (!ok || entry_path(key, path, sizeof(path)) < 0 || rename(tmp, path) < 0) {
+        cache_abort(tmp);
+        return -1;
+    }
+    free(tmp);
+    return 0;
+}
+
+void cache_abort(char *tmp) {
+    unlink(tmp);
+    free(tmp);
+}
+
+int cache_clear(void) {
+    const char *dir = get_cache_dir();
+    if (dir == NULL)
+        return -1;
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        perror(dir);
+        return -1;
+    }
+    int nb_removed = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        // Entrées (hachage en hexadécimal) et fichiers temporaires (.tmpXXXXXX) abandonnés
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0 && unlinkat(dirfd(d), e->d_name, 0) == 0)
+            nb_removed++;
+    }
+    closedir(d);
+    return nb_removed;
+}
+
+void cache_print_status(void) {
+    const char *dir = get_cache_dir();
+    printf("cache: %s, %lu succès, %lu échecs\n", dir != NULL ? dir : "(indisponible)", nb_hits, nb_misses);
+}
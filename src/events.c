@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include "csapp.h"
+#include "events.h"
+
+/*
+ * Trois sources dans l'instance epoll : le signalfd et le minuteur, enregistrés une fois pour toutes,
+ * et le descripteur d'entrée passé à events_wait, enregistré tant que les appels successifs portent
+ * sur le même descripteur (il est retiré dès qu'on attend sans entrée, sinon une entrée lisible mais
+ * pas encore lue réveillerait la boucle en permanence pendant l'attente d'un job).
+ */
+#define SOURCE_SIGNALS 0
+#define SOURCE_TIMER   1
+#define SOURCE_INPUT   2
+
+#define MAX_EVENTS     4
+#define SIGINFO_BATCH  16
+
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static int timer_fd = -1;
+static int watched_fd = -1;           // descripteur d'entrée enregistré dans epoll
+static int watched_always_ready = 0;  // fichier ordinaire : refusé par epoll, toujours lisible
+static sigset_t handled_mask;         // signaux bloqués et lus sur signal_fd
+static sigset_t child_mask;           // masque d'origine, rétabli dans les fils
+static event_handler_t handlers[NSIG];
+
+static unsigned long nb_wakeups = 0;
+static unsigned long nb_signals_read = 0;
+static unsigned long nb_handler_calls = 0;
+
+static void add_source(int fd, uint32_t source) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = source };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        unix_error("epoll_ctl");
+}
+
+void events_init(void) {
+    Sigemptyset(&handled_mask);
+    Sigprocmask(SIG_BLOCK, &handled_mask, &child_mask);
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        unix_error("epoll_create1");
+    if ((signal_fd = signalfd(-1, &handled_mask, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+        unix_error("signalfd");
+    if ((timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+        unix_error("timerfd_create");
+    add_source(signal_fd, SOURCE_SIGNALS);
+    add_source(timer_fd, SOURCE_TIMER);
+}
+
+event_handler_t events_on_signal(int signum, event_handler_t handler) {
+    event_handler_t previous = handlers[signum];
+    sigset_t mask;
+
+    Sigemptyset(&mask);
+    Sigaddset(&mask, signum);
+    if (handler != NULL) {
+        Sigprocmask(SIG_BLOCK, &mask, NULL);
+        Sigaddset(&handled_mask, signum);
+    } else {
+        // Retiré du signalfd avant d'être débloqué : un signal en attente prend son effet habituel
+        Sigdelset(&handled_mask, signum);
+        if (!sigismember(&child_mask, signum))
+            Sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    }
+    handlers[signum] = handler;
+    if (signalfd(signal_fd, &handled_mask, 0) < 0)
+        unix_error("signalfd");
+    return previous;
+}
+
+const sigset_t *events_child_mask(void) {
+    return &child_mask;
+}
+
+int events_interrupt_pending(void) {
+    sigset_t pending;
+    return sigismember(&handled_mask, SIGINT) && sigpending(&pending) == 0 && sigismember(&pending, SIGINT);
+}
+
+/**
+ * @brief Enregistre fd comme entrée surveillée à la place de la précédente (-1 : aucune entrée).
+ */
+static void watch_input(int fd) {
+    if (fd == watched_fd)
+        return;
+    // Erreur ignorée : l'ancienne entrée a pu être fermée entre-temps
+    if (watched_fd >= 0 && !watched_always_ready)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watched_fd, NULL);
+    watched_fd = fd;
+    watched_always_ready = 0;
+    if (fd >= 0) {
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = SOURCE_INPUT };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            if (errno != EPERM)
+                unix_error("epoll_ctl");
+            watched_always_ready = 1;
+        }
+    }
+}
+
+/**
+ * @brief Lit tous les signaux en attente sur signal_fd et appelle une fois le traitant de chacun :
+ * plusieurs SIGCHLD arrivés ensemble sont traités par un seul appel (qui récolte tous les fils terminés).
+ */
+static void dispatch_signals(void) {
+    struct signalfd_siginfo info[SIGINFO_BATCH];
+    sigset_t pending;
+    ssize_t n;
+
+    Sigemptyset(&pending);
+    while ((n = read(signal_fd, info, sizeof(info))) > 0) {
+        for (size_t i = 0; i < n / sizeof(info[0]); i++) {
+            sigaddset(&pending, info[i].ssi_signo);
+            nb_signals_read++;
+        }
+    }
+    for (int signum = 1; signum < NSIG; signum++) {
+        if (sigismember(&pending, signum) && handlers[signum] != NULL) {
+            nb_handler_calls++;
+            handlers[signum](signum);
+        }
+    }
+}
+
+int events_wait(int fd) {
+    struct epoll_event ev[MAX_EVENTS];
+    int result = 0;
+    int n;
+
+    if (epoll_fd < 0)
+        return EVENT_INPUT;
+    watch_input(fd);
+
+    // Entrée toujours lisible : seulement relever les signaux et le minuteur déjà arrivés
+    do {
+        n = epoll_wait(epoll_fd, ev, MAX_EVENTS, watched_always_ready ? 0 : -1);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        unix_error("epoll_wait");
+    nb_wakeups++;
+
+    for (int i = 0; i < n; i++) {
+        switch (ev[i].data.u32) {
+        case SOURCE_SIGNALS:
+            dispatch_signals();
+            result |= EVENT_SIGNAL;
+            break;
+        case SOURCE_TIMER: {
+            uint64_t expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                result |= EVENT_TIMER;
+            break;
+        }
+        case SOURCE_INPUT:
+            result |= EVENT_INPUT;
+            break;
+        }
+    }
+    if (watched_always_ready)
+        result |= EVENT_INPUT;
+    return result;
+}
+
+int events_poll(const int *fds, int nb_fds) {
+    static struct pollfd *pfds = NULL;
+    static int capacity = 0;
+    int result = 0;
+    int n;
+
+    if (epoll_fd < 0)
+        return EVENT_INPUT;
+    if (capacity < nb_fds + 2) {
+        capacity = nb_fds + 2;
+        pfds = Realloc(pfds, capacity * sizeof(struct pollfd));
+    }
+    pfds[0] = (struct pollfd){ .fd = signal_fd, .events = POLLIN };
+    pfds[1] = (struct pollfd){ .fd = timer_fd, .events = POLLIN };
+    for (int i = 0; i < nb_fds; i++)
+        pfds[i + 2] = (struct pollfd){ .fd = fds[i], .events = POLLIN };
+
+    do {
+        n = poll(pfds, nb_fds + 2, -1);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        unix_error("poll");
+    nb_wakeups++;
+
+    if (pfds[0].revents != 0) {
+        dispatch_signals();
+        result |= EVENT_SIGNAL;
+    }
+    if (pfds[1].revents != 0) {
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+            result |= EVENT_TIMER;
+    }
+    for (int i = 0; i < nb_fds; i++) {
+        if (pfds[i + 2].revents != 0) {
+            result |= EVENT_INPUT;
+            break;
+        }
+    }
+    return result;
+}
+
+void events_set_timer(const struct timespec *delay) {
+    struct itimerspec its;
+
+    if (timer_fd < 0)
+        return;
+    memset(&its, 0, sizeof(its));
+    if (delay != NULL) {
+        its.it_value = *delay;
+        // Un délai nul désarmerait le minuteur : échéance immédiate à la place
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+            its.it_value.tv_nsec = 1;
+    }
+    if (timerfd_settime(timer_fd, 0, &its, NULL) < 0)
+        unix_error("timerfd_settime");
+}
+
+void events_print_stats(void) {
+    printf("réveils de la boucle : %lu\n", nb_wakeups);
+    printf("signaux lus          : %lu\n", nb_signals_read);
+    printf("traitants appelés    : %lu\n", nb_handler_calls);
+}
@@ -1,6 +1,17 @@
+#include <spawn.h>
+#include <limits.h>
+#include <sys/sendfile.h>
 #include "csapp.h"
 #include "execute.h"
 #include "jobs.h"
+#include "pathcache.h"
+#include "builtin.h"
+#include "cache.h"
+#include "events.h"
+#include "forkserver.h"
+#include "notify.h"
+#include "parallel.h"
+#include "trace.h"
 
 #ifdef DEBUG
 #define DEBUG_PRINT(...) printf("[DEBUG] : ") ;printf(__VA_ARGS__); 
@@ -27,49 +38,142 @@ static void build_cmdline_str(struct cmdline *l, char *buf, size_t bufsize) {
         strncat(buf, " &", bufsize - strlen(buf) - 1);
 }
 
-/* Gestion des signaux */
+/* Statut de fin du dernier job de premier plan (mis à jour par sigchld_handler) */
+static int last_fg_status = 0;
+
+/* Dernier job ajouté à la table par execute_command_line (pour le préfixe time) */
+static job_t *last_launched = NULL;
+
+/* Préfixe time : rapport des ressources consommées */
+
+static double timespec_diff(const struct timespec *end, const struct timespec *start) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static double timeval_diff(const struct timeval *end, const struct timeval *start) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec) * 1e-6;
+}
+
+/**
+ * @brief Affiche une ligne du rapport de time : temps réel, utilisateur et système, RSS maximale
+ * (Ko) et changements de contexte volontaires / involontaires.
+ */
+static void print_usage_line(FILE *out, const char *label, double real, double user, double sys,
+                             long maxrss, long nvcsw, long nivcsw) {
+    int width = 20;
+    for (const char *c = label; *c; c++) // colonne de 20 caractères, pas de 20 octets (UTF-8)
+        if ((*c & 0xC0) == 0x80)
+            width++;
+    fprintf(out, "%-*s réel %8.3fs  util %8.3fs  sys %8.3fs  RSS max %8ld Ko  commutations %ld vol. / %ld invol.\n",
+            width, label, real, user, sys, maxrss, nvcsw, nivcsw);
+}
+
+/**
+ * @brief Rapport de time pour un job terminé : le job entier (temps réel du lancement à la fin de la
+ * dernière étape, temps CPU et commutations cumulés, RSS maximale de ses étapes) puis chaque étape.
+ * @param j Le job (JOB_DONE)
+ * @return char* Le rapport, à libérer
+ */
+static char *job_times_report(const job_t *j) {
+    char *report;
+    size_t size;
+    FILE *out = open_memstream(&report, &size);
+    const struct timespec *end = &j->start;
+    double user = 0, sys = 0;
+    long maxrss = 0, nvcsw = 0, nivcsw = 0;
+    const struct timeval zero = { 0, 0 };
+    char label[32];
+
+    if (out == NULL)
+        unix_error("open_memstream");
+    for (int i = 0; i < j->nb_procs; i++) {
+        const proc_t *p = &j->procs[i];
+        if (timespec_diff(&p->end, end) > 0)
+            end = &p->end;
+        user += timeval_diff(&p->rusage.ru_utime, &zero);
+        sys += timeval_diff(&p->rusage.ru_stime, &zero);
+        if (p->rusage.ru_maxrss > maxrss)
+            maxrss = p->rusage.ru_maxrss;
+        nvcsw += p->rusage.ru_nvcsw;
+        nivcsw += p->rusage.ru_nivcsw;
+    }
+    fprintf(out, "time: [%d] %s\n", j->jid, j->cmdline);
+    print_usage_line(out, "  total", timespec_diff(end, &j->start), user, sys, maxrss, nvcsw, nivcsw);
+    for (int i = 0; j->nb_procs > 1 && i < j->nb_procs; i++) {
+        const proc_t *p = &j->procs[i];
+        snprintf(label, sizeof(label), "  étape %d (%d)", i + 1, (int)p->pid);
+        print_usage_line(out, label, timespec_diff(&p->end, &j->start),
+                         timeval_diff(&p->rusage.ru_utime, &zero), timeval_diff(&p->rusage.ru_stime, &zero),
+                         p->rusage.ru_maxrss, p->rusage.ru_nvcsw, p->rusage.ru_nivcsw);
+    }
+    fclose(out);
+    return report;
+}
+
+int exit_code_of(int status) {
+    if (WIFEXITED(status))
+        return WEXITSTATUS(status);
+    if (WIFSIGNALED(status))
+        return 128 + WTERMSIG(status);
+    if (WIFSTOPPED(status))
+        return 128 + WSTOPSIG(status);
+    return 1;
+}
+
+/* Gestion des signaux : traitants appelés par la boucle d'événements (events_wait), hors contexte de signal */
 
 /**
- * @brief Traitant SIGCHLD
- * Pour chaque enfant terminé ou suspendu :
- *   - suspendu : on passe le job à JOB_STOPPED
- *   - terminé : on supprime le job de la table et on notifie Done si arrière-plan
+ * @brief Traitant SIGCHLD (appelé aussi directement par wait quand le pidfd d'un processus devient lisible)
+ * Pour chaque enfant (n'importe quelle étape d'un job) terminé ou suspendu :
+ *   - suspendu : on passe le processus et son job à JOB_STOPPED
+ *   - terminé : on enregistre le statut et la date de fin du processus ; quand c'est le dernier processus
+ *     du job, le job passe à JOB_DONE (retiré de la table au prochain add_job) et on notifie Done si arrière-plan
+ * Les notifications sont mises en file (notify_job) et écrites avant le prompt, ou dès la fin du traitant en mode immédiat.
  */
 void sigchld_handler(int signum) {
     int status;
     pid_t pid;
+    struct rusage ru;
 
-    while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED)) > 0) {
-        job_t *j = get_job_by_pgid(pid);
+    // wait4 plutôt que waitpid : les ressources consommées par chaque étape sont gardées pour time
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED, &ru)) > 0) {
+        TRACE(TRACE_SIGCHLD, pid, status);
+        proc_t *p = get_proc_by_pid(pid);
+        job_t *j = p != NULL ? p->job : NULL;
 
         if (WIFSTOPPED(status)) { // Processus suspendu
-            if (j != NULL) {
-                j->state = JOB_STOPPED;
-                // handler de signal => Sio_puts Sio_putl au lieu de printf 
-                Sio_puts("\n[");
-                Sio_putl(j->jid);
-                Sio_puts("] ");
-                Sio_putl((long)j->pgid);
-                Sio_puts(" Stopped  ");
-                Sio_puts(j->cmdline);
-                Sio_puts("\n");
+            int prev = -1;
+            if (p != NULL) {
+                mark_proc_stopped(p);
+                prev = mark_job_stopped(j);
+            }
+            if (prev >= 0) {
+                if (prev == JOB_FOREGROUND)
+                    last_fg_status = exit_code_of(status);
+                notify_job("\n[%d] %d Stopped  %s\n", j->jid, (int)j->pgid, j->cmdline);
             }
         } else if (WIFEXITED(status) || WIFSIGNALED(status)) { // Processus terminé
-            if (j != NULL) {
-                // Notifier uniquement si le job était en arrière-plan
-                if (j->state == JOB_RUNNING || j->state == JOB_STOPPED) {
-                    Sio_puts("[");
-                    Sio_putl(j->jid);
-                    Sio_puts("] ");
-                    Sio_putl((long)j->pgid);
-                    Sio_puts(" Done     ");
-                    Sio_puts(j->cmdline);
-                    Sio_puts("\n");
+            // Le job ne se termine qu'avec son dernier processus ; son statut est celui de la dernière étape
+            int prev = p != NULL ? mark_proc_done(p, status, &ru) : -1;
+            if (prev >= 0) {
+                if (prev == JOB_FOREGROUND)
+                    last_fg_status = exit_code_of(j->status);
+                if (j->on_done != NULL) {
+                    // Le job appartient à une commande intégrée (parallel...) qui gère elle-même sa fin
+                    j->on_done(j->pgid, j->status);
+                } else if (prev == JOB_RUNNING || prev == JOB_STOPPED) {
+                    // Notifier uniquement si le job était en arrière-plan
+                    notify_job("[%d] %d Done     %s\n", j->jid, (int)j->pgid, j->cmdline);
+                }
+                if (j->timed) { // Job lancé par time, pas terminé au premier plan (arrière-plan ou suspendu)
+                    char *report = job_times_report(j);
+                    notify_job("%s", report);
+                    free(report);
                 }
-                delete_job_by_pgid(pid);
             }
         }
     }
+    notify_end_batch();
 }
 
 /**
@@ -79,7 +183,7 @@ void sigchld_handler(int signum) {
 void sigtstp_handler(int signum) {
     job_t *fg = get_fg_job();
     if (fg != NULL) {
-        kill(-(fg->pgid), SIGTSTP);
+        job_signal(fg, SIGTSTP);
     }
 }
 
@@ -90,7 +194,7 @@ void sigtstp_handler(int signum) {
 void sigint_handler(int signum) {
     job_t *fg = get_fg_job();
     if (fg != NULL) {
-        kill(-(fg->pgid), SIGINT);
+        job_signal(fg, SIGINT);
     }
 }
 
@@ -112,10 +216,11 @@ void setup_signals_handlers_shell() {
         }
     }
     
-    // Ignorer SIGINT et SIGTSTP dans le shell
-    Signal(SIGCHLD, sigchld_handler);
-    Signal(SIGINT,  sigint_handler);
-    Signal(SIGTSTP, sigtstp_handler);
+    // SIGCHLD, SIGINT et SIGTSTP : bloqués et lus sur un signalfd par la boucle d'événements
+    events_init();
+    events_on_signal(SIGCHLD, sigchld_handler);
+    events_on_signal(SIGINT,  sigint_handler);
+    events_on_signal(SIGTSTP, sigtstp_handler);
     
     Signal(SIGTTOU, SIG_IGN);
     Signal(SIGTTIN, SIG_IGN);
@@ -144,13 +249,351 @@ void execute_simple_command(char** cmd_simple, int fd_in, int fd_out) {
         close(fd_out);
     }
     
+    // Chemin résolu via le cache de PATH, execvp en dernier recours (scripts sans shebang...)
+    const char *path = pathcache_lookup(cmd_simple[0]);
+    if (path != NULL)
+        execv(path, cmd_simple);
     execvp(cmd_simple[0], cmd_simple);
+    // _exit et non exit : exit() resynchroniserait la position de lecture du stdin partagé avec le shell
     if (errno == ENOENT) {
         printf("%s: command not found\n", cmd_simple[0]);
-        exit(127);
+        fflush(stdout);
+        _exit(127);
     }
     perror("execvp");
-    exit(1);
+    _exit(1);
+}
+
+
+/**
+ * @brief Prépare un fils créé par Fork() : masque de signaux, signaux par défaut et groupe de processus.
+ * @param mask Masque de signaux à restaurer dans le fils
+ * @param pgid Groupe de processus à rejoindre, 0 pour créer un nouveau groupe
+ */
+static void setup_forked_child(const sigset_t *mask, pid_t pgid) {
+    // Restaurer le masque de signaux d'origine (signaux du shell bloqués pour son signalfd)
+    Sigprocmask(SIG_SETMASK, mask, NULL);
+
+    // Restaurer les handlers de signaux par défaut dans les enfants
+    Signal(SIGINT, SIG_DFL);
+    Signal(SIGTSTP, SIG_DFL);
+    Signal(SIGTTOU, SIG_DFL);
+    Signal(SIGTTIN, SIG_DFL);
+
+    setpgid(0, pgid);
+}
+
+
+/**
+ * @brief Exécute une commande intégrée d'étape dans un processus fils d'une séquence, sans execvp.
+ * Entrée et sortie sont déjà en place et les autres descripteurs du shell fermés (setup_child_fds) :
+ * rien n'est fermé par un exec, les lecteurs des pipes de la séquence voient bien la fin de fichier.
+ * @param builtin La commande intégrée à exécuter
+ * @param cmd_simple Un tableau de strings représentant la commande simple à exécuter
+ */
+static void execute_stage_builtin(stage_builtin_t builtin, char **cmd_simple) {
+    #ifdef DEBUG
+    DEBUG_PRINT("Executing builtin stage: %s, pid : %d\n", cmd_simple[0], getpid());
+    #endif
+
+    _exit(builtin(cmd_simple, STDIN_FILENO, STDOUT_FILENO));
+}
+
+
+/**
+ * @brief Lance une commande simple avec posix_spawn (clone(CLONE_VM|CLONE_VFORK) dans la glibc) :
+ * le coût du lancement ne dépend plus de la taille de l'espace d'adressage du shell.
+ * Les dup2/close du fils sont décrits par des file actions, le setpgid, la remise à SIG_DFL
+ * des signaux et le masque par des attributs de spawn.
+ * @param cmd_simple Un tableau de strings représentant la commande simple à exécuter
+ * @param fd_in Descripteur de fichier pour la redirection d'entrée
+ * @param fd_out Descripteur de fichier pour la redirection de sortie
+ * @param pgid Groupe de processus à rejoindre, 0 pour créer un nouveau groupe
+ * @param mask Masque de signaux à appliquer dans le fils
+ * @param extra_fds 1 si la commande hérite d'autres descripteurs (substitution de processus) : elle
+ * est alors lancée par le shell, le serveur de lancement ne recevant que l'entrée, la sortie et l'erreur
+ * @return pid_t pid du fils, ou -1 (errno positionné) si le lancement a échoué : l'appelant
+ * se replie alors sur Fork() + execute_simple_command.
+ */
+static pid_t spawn_simple_command(char **cmd_simple, int fd_in, int fd_out, pid_t pgid, const sigset_t *mask, int extra_fds) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t sigdef;
+    pid_t pid;
+    int err;
+
+    if ((err = posix_spawn_file_actions_init(&actions)) != 0) {
+        errno = err;
+        return -1;
+    }
+    if ((err = posix_spawnattr_init(&attr)) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        errno = err;
+        return -1;
+    }
+
+    // Mêmes redirections que setup_child_fds (fd_in et fd_out peuvent être le même /dev/null)
+    if (fd_in != STDIN_FILENO)
+        posix_spawn_file_actions_adddup2(&actions, fd_in, STDIN_FILENO);
+    if (fd_out != STDOUT_FILENO)
+        posix_spawn_file_actions_adddup2(&actions, fd_out, STDOUT_FILENO);
+    // Tous les descripteurs du shell sont O_CLOEXEC ; closefrom ferme en plus ceux hérités sans
+    // O_CLOEXEC par le shell lui-même (un seul close_range), sauf à garder ceux d'une substitution
+    if (!extra_fds)
+        posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+
+    // Signaux gérés ou ignorés par le shell => comportement par défaut dans le fils
+    sigemptyset(&sigdef);
+    sigaddset(&sigdef, SIGINT);
+    sigaddset(&sigdef, SIGTSTP);
+    sigaddset(&sigdef, SIGTTOU);
+    sigaddset(&sigdef, SIGTTIN);
+    posix_spawnattr_setsigdefault(&attr, &sigdef);
+    posix_spawnattr_setsigmask(&attr, mask);
+    posix_spawnattr_setpgroup(&attr, pgid);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+    // Résolution via le cache de PATH plutôt que posix_spawnp (qui tente un execve par répertoire)
+    TRACE(TRACE_SPAWN_BEGIN, 0, 0);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const char *path = pathcache_lookup(cmd_simple[0]);
+        if (path == NULL) {
+            err = ENOENT;
+            break;
+        }
+        // Serveur de lancement (shell -z) s'il est lancé, sinon posix_spawn dans le shell
+        err = extra_fds ? -1 : forkserver_spawn(&pid, path, cmd_simple, fd_in, fd_out, pgid);
+        if (err < 0)
+            err = posix_spawn(&pid, path, &actions, &attr, cmd_simple, environ);
+        // Binaire en cache disparu : oublier l'entrée et refaire une résolution
+        if (err != ENOENT || pathcache_forget(cmd_simple[0]) < 0)
+            break;
+    }
+
+    TRACE(TRACE_SPAWN_END, err == 0 ? pid : -1, 0);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0) {
+        #ifdef DEBUG
+        DEBUG_PRINT("posix_spawn failed for %s (%s), falling back to Fork\n", cmd_simple[0], strerror(err));
+        #endif
+        errno = err;
+        return -1;
+    }
+    #ifdef DEBUG
+    DEBUG_PRINT("Spawned simple command: %s, pid : %d, fd_in : %d, fd_out : %d\n", cmd_simple[0], pid, fd_in, fd_out);
+    #endif
+    return pid;
+}
+
+
+/* Taille des buffers de pipe (F_SETPIPE_SZ), 0 pour garder la taille par défaut du noyau */
+static int pipe_buffer_size = 0;
+/* Échec de F_SETPIPE_SZ déjà signalé pour la taille courante */
+static int pipe_buffer_size_warned = 0;
+
+/**
+ * @brief Lit la taille maximale autorisée pour un pipe (/proc/sys/fs/pipe-max-size).
+ * @return La taille maximale en octets, ou -1 si elle ne peut pas être lue.
+ */
+static long read_pipe_max_size(void) {
+    FILE *f = fopen("/proc/sys/fs/pipe-max-size", "re");
+    long max = -1;
+    if (f == NULL)
+        return -1;
+    if (fscanf(f, "%ld", &max) != 1)
+        max = -1;
+    fclose(f);
+    return max;
+}
+
+int set_pipe_buffer_size(long size) {
+    long max = read_pipe_max_size();
+    if (size < 0)
+        size = 0;
+    if (max <= 0 || max > INT_MAX) // limite inconnue : au moins ne pas tronquer en int
+        max = INT_MAX;
+    if (size > max)
+        size = max;
+    pipe_buffer_size = (int)size;
+    pipe_buffer_size_warned = 0;
+    return pipe_buffer_size;
+}
+
+int get_pipe_buffer_size(void) {
+    return pipe_buffer_size;
+}
+
+/**
+ * @brief Crée d'un coup les nb_pipes pipes d'une séquence de commandes (pipe2 + O_CLOEXEC).
+ * Le pipe k relie la commande k à la commande k+1 : pipes[2k] en lecture, pipes[2k+1] en écriture.
+ * @param pipes Tableau de 2 * nb_pipes descripteurs à remplir
+ * @param nb_pipes Nombre de pipes à créer
+ * @return 0 si succès, -1 sinon (les pipes déjà créés sont refermés).
+ */
+static int create_pipes(int *pipes, int nb_pipes) {
+    for (int k = 0; k < nb_pipes; k++) {
+        if (pipe2(&pipes[2 * k], O_CLOEXEC) < 0) {
+            perror("pipe2");
+            for (int m = 0; m < 2 * k; m++)
+                Close(pipes[m]);
+            return -1;
+        }
+        // Taille du buffer configurée par la commande pipesize (limitée par pipe-max-size)
+        // (refus du noyau, par exemple au-delà de pipe-user-pages-soft : signalé une fois par taille)
+        if (pipe_buffer_size > 0 && fcntl(pipes[2 * k + 1], F_SETPIPE_SZ, pipe_buffer_size) < 0
+            && !pipe_buffer_size_warned) {
+            fprintf(stderr, "pipesize: taille %d non appliquée : %s\n", pipe_buffer_size, strerror(errno));
+            pipe_buffer_size_warned = 1;
+        }
+        #ifdef DEBUG
+        DEBUG_PRINT("Created pipe %d: read : %d, write : %d\n", k, pipes[2 * k], pipes[2 * k + 1]);
+        #endif
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Indique si la ligne de commande est une simple copie par redirections ("cat < in [> out]",
+ * ou "cat" avec un here-document ou une here-string) depuis un fichier ordinaire. Une autre source
+ * (/dev/zero, tube nommé, terminal) peut ne jamais finir : elle est laissée à une commande externe,
+ * que Ctrl+C et Ctrl+Z atteignent.
+ * @param l Un pointeur vers un cmdline
+ * @param fd_in Le descripteur de la redirection d'entrée
+ * @return int 1 si la copie peut être faite par le shell sans créer de processus, 0 sinon.
+ */
+static int is_redirection_copy(struct cmdline *l, int fd_in) {
+    struct stat st;
+    return (l->in != NULL || l->in_data != NULL) && !l->background
+        && l->seq[0] != NULL && l->seq[1] == NULL
+        && strcmp(l->seq[0][0], "cat") == 0 && l->seq[0][1] == NULL
+        && fstat(fd_in, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/* /dev/null partagé par les jobs en arrière-plan (O_RDWR | O_CLOEXEC), -1 tant qu'il n'est pas ouvert */
+static int devnull_fd = -1;
+
+int get_devnull_fd(void) {
+    if (devnull_fd < 0)
+        devnull_fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    return devnull_fd;
+}
+
+/**
+ * @brief Ferme dans le shell un descripteur de redirection, sauf l'entrée ou la sortie standard
+ * std_fd, le /dev/null partagé et une ouverture échouée (-1).
+ */
+static void close_redirection(int fd, int std_fd) {
+    if (fd >= 0 && fd != std_fd && fd != devnull_fd)
+        Close(fd);
+}
+
+/**
+ * @brief Crée l'entrée d'un here-document ou d'une here-string : un memfd (aucun fichier sur disque,
+ * aucun processus pour remplir un pipe) qui contient data, scellé contre toute modification et
+ * positionné au début.
+ * @param data Le contenu
+ * @param len Sa taille
+ * @return int Le descripteur (O_CLOEXEC), ou -1 en cas d'erreur (errno positionné)
+ */
+static int open_here_document(const char *data, size_t len) {
+    int fd = memfd_create("here-document", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return -1;
+    for (size_t done = 0; done < len; ) {
+        ssize_t n = write(fd, data + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            return -1;
+        }
+        done += n;
+    }
+    // Scellé : ni la commande ni personne d'autre ne peut plus le modifier
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0
+        || lseek(fd, 0, SEEK_SET) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Copie tout le contenu de fd_in vers fd_out dans le noyau, sans passer par l'espace utilisateur.
+ * Essaie copy_file_range, puis sendfile, puis splice (si l'un des deux est un pipe),
+ * et en dernier recours read/write. Les offsets des fichiers avancent au fur et à mesure :
+ * chaque méthode de repli reprend là où la précédente s'est arrêtée. La copie se fait dans le shell,
+ * hors de tout job : Ctrl+C est vérifié entre deux blocs.
+ * @param fd_in Descripteur source
+ * @param fd_out Descripteur destination
+ * @return int 0 si succès, 1 en cas d'erreur, 130 si interrompue par Ctrl+C.
+ */
+static int kernel_copy(int fd_in, int fd_out) {
+    const size_t chunk = 64 << 20;
+    struct stat st_in, st_out;
+    int can_splice = 0;
+    ssize_t n;
+
+    if (fstat(fd_in, &st_in) == 0 && fstat(fd_out, &st_out) == 0) {
+        can_splice = S_ISFIFO(st_in.st_mode) || S_ISFIFO(st_out.st_mode);
+        // "cat < f >> f" : la copie relirait sans fin ce qu'elle vient d'ajouter (même test que cat)
+        if (S_ISREG(st_out.st_mode) && st_in.st_dev == st_out.st_dev && st_in.st_ino == st_out.st_ino
+            && lseek(fd_in, 0, SEEK_CUR) < st_in.st_size) {
+            fprintf(stderr, "cat: -: input file is output file\n");
+            return 1;
+        }
+    }
+
+    // copy_file_range : copie entre fichiers (reflink possible selon le système de fichiers)
+    while ((n = copy_file_range(fd_in, NULL, fd_out, NULL, chunk, 0)) > 0)
+        if (events_interrupt_pending())
+            return 130;
+    if (n == 0)
+        return 0;
+    #ifdef DEBUG
+    DEBUG_PRINT("copy_file_range failed (%s), trying sendfile\n", strerror(errno));
+    #endif
+
+    // sendfile : source "mmapable", destination quelconque (pas en O_APPEND)
+    while ((n = sendfile(fd_out, fd_in, NULL, chunk)) > 0)
+        if (events_interrupt_pending())
+            return 130;
+    if (n == 0)
+        return 0;
+
+    // splice : l'une des deux extrémités doit être un pipe
+    if (can_splice) {
+        while ((n = splice(fd_in, NULL, fd_out, NULL, chunk, SPLICE_F_MOVE)) > 0)
+            if (events_interrupt_pending())
+                return 130;
+        if (n == 0)
+            return 0;
+    }
+
+    // Dernier recours : copie par l'espace utilisateur
+    char buf[MAXBUF];
+    while ((n = read(fd_in, buf, sizeof(buf))) > 0) {
+        if (events_interrupt_pending())
+            return 130;
+        char *p = buf;
+        while (n > 0) {
+            ssize_t w = write(fd_out, p, n);
+            if (w < 0) {
+                perror("cat: write");
+                return 1;
+            }
+            p += w;
+            n -= w;
+        }
+    }
+    if (n < 0) {
+        perror("cat: read");
+        return 1;
+    }
+    return 0;
 }
 
 
@@ -169,44 +612,194 @@ int is_last_simple_command(struct cmdline *l, int i) {
 // Cleanup de la fonction execute_command_line
 void parent_cleanup(int fd_in, int fd_out, int background, pid_t* child_pids, int nb_cmds_executed, int* status, pid_t pgid) {
     // Fermer les descripteurs ouverts
-    if (fd_in != STDIN_FILENO) Close(fd_in);
-    if (fd_out != STDOUT_FILENO) Close(fd_out);
+    close_redirection(fd_in, STDIN_FILENO);
+    close_redirection(fd_out, STDOUT_FILENO);
 
     if (!background) {
         // Attendre la fin du job de premier plan (terminal + sigsuspend + retour terminal)
-        wait_for_fg_job(pgid);
+        *status = wait_for_fg_job(pgid);
     }
     free(child_pids);
 }
 
-void wait_for_fg_job(pid_t pgid) {
+int wait_for_fg_job(pid_t pgid) {
     
     if (pgid > 0 && isatty(STDIN_FILENO)) {
+        TRACE(TRACE_TCSETPGRP, pgid, 0);
         if (tcsetpgrp(STDIN_FILENO, pgid) < 0) {
             if (errno != ESRCH && errno != EPERM)
                 perror("tcsetpgrp to child (wait_for_fg_job)");
         }
     }
 
-    // Attendre que le job de premier plan disparaisse du foreground
-    sigset_t old_mask;
-    jobs_block_sigchld(&old_mask);
-    while (get_fg_job() != NULL) {
-        Sigsuspend(&old_mask);
-    }
-    jobs_unblock_sigchld(&old_mask);
+    // Attendre que le job de premier plan disparaisse du foreground (fin ou suspension vue par sigchld_handler)
+    jobs_mask_avoided();
+    while (get_fg_job() != NULL)
+        events_wait(-1);
 
     // Rendre le terminal au shell car le job de premier plan a disparu du foreground
     if (isatty(STDIN_FILENO)) {
+        TRACE(TRACE_TCSETPGRP, getpgrp(), 0);
         if (tcsetpgrp(STDIN_FILENO, getpgrp()) < 0)
             perror("tcsetpgrp to shell (wait_for_fg_job)");
     }
+    return last_fg_status;
+}
+
+/* Substitutions de processus <(cmd) et >(cmd) */
+
+/**
+ * @brief Substitution en cours de lancement.
+ */
+typedef struct {
+    int   fd;       /* Extrémité du pipe côté commande principale (O_CLOEXEC), -1 une fois fermée dans le shell */
+    char **slot;    /* Case de l'argument dans l'étape, où l'argument d'origine est remis une fois l'étape lancée */
+    char  path[24]; /* "/dev/fd/N", qui remplace l'argument pendant le lancement de l'étape */
+} subst_launch_t;
+
+/**
+ * @brief Ferme les descripteurs lo à hi (close_range, sinon un close par descripteur jusqu'à la
+ * limite du processus si le noyau ne le fournit pas).
+ */
+static void close_fd_range(unsigned int lo, unsigned int hi) {
+    if (lo > hi || close_range(lo, hi, 0) == 0)
+        return;
+    long max = sysconf(_SC_OPEN_MAX);
+    for (long fd = lo; fd <= (long)hi && fd < max; fd++)
+        close(fd);
+}
+
+/**
+ * @brief Dans un fils créé par Fork() (commande intégrée d'étape ou repli) : place fd_in et fd_out
+ * en entrée et sortie standard, puis ferme tous les autres descripteurs hérités du shell, sauf les
+ * extrémités des substitutions destinées à l'étape stage. Sans exec, O_CLOEXEC ne les fermerait
+ * pas, et une extrémité d'écriture gardée ouverte empêcherait un lecteur de voir la fin de fichier.
+ * @param fd_in Descripteur à placer en entrée standard
+ * @param fd_out Descripteur à placer en sortie standard
+ * @param l La ligne de commande, NULL si pas de substitution
+ * @param subst Les substitutions de la ligne, NULL si aucune
+ * @param stage L'étape du fils, -1 pour une étape d'une substitution
+ */
+static void setup_child_fds(int fd_in, int fd_out, struct cmdline *l, const subst_launch_t *subst, int stage) {
+    if (fd_in != STDIN_FILENO)
+        dup2(fd_in, STDIN_FILENO);
+    if (fd_out != STDOUT_FILENO)
+        dup2(fd_out, STDOUT_FILENO);
+
+    // Intervalles entre les extrémités gardées, par ordre croissant
+    unsigned int from = STDERR_FILENO + 1;
+    for (;;) {
+        int next = -1;
+        for (int k = 0; subst != NULL && k < l->nb_subst; k++)
+            if (l->subst[k].stage == stage && subst[k].fd >= (int)from && (next < 0 || subst[k].fd < next))
+                next = subst[k].fd;
+        if (next < 0)
+            break;
+        close_fd_range(from, next - 1);
+        from = next + 1;
+    }
+    close_fd_range(from, ~0U);
+}
+
+/**
+ * @brief Lance la séquence de la substitution k dans le groupe *pgid (créé par sa première étape si
+ * *pgid vaut 0), reliée à un nouveau pipe : sa dernière étape écrit dans le pipe pour <(cmd), sa
+ * première étape y lit pour >(cmd). L'autre extrémité (O_CLOEXEC) est rangée dans subst[k].fd, pour
+ * l'étape de la commande principale qui la recevra en /dev/fd/N.
+ * @param l La ligne de commande
+ * @param k L'indice de la substitution
+ * @param subst Les substitutions de la ligne
+ * @param pids Les pid du job, complétés par ceux de la substitution
+ * @param nb_pids Le nombre de pid du job
+ * @param pgid Le groupe du job
+ * @param mask Masque de signaux à appliquer dans les fils
+ * @return int 0 si succès, -1 si un pipe n'a pas pu être créé
+ */
+static int spawn_substitution(struct cmdline *l, int k, subst_launch_t *subst, pid_t *pids, int *nb_pids, pid_t *pgid, const sigset_t *mask) {
+    struct procsubst *ps = &l->subst[k];
+    int p[2];
+    int nb_stages = 0;
+
+    while (ps->seq[nb_stages] != NULL)
+        nb_stages++;
+    int nb_pipes = nb_stages - 1;
+    int *pipes = NULL;
+    if (create_pipes(p, 1) < 0)
+        return -1;
+    if (nb_pipes > 0) {
+        pipes = Malloc(2 * nb_pipes * sizeof(int));
+        if (create_pipes(pipes, nb_pipes) < 0) {
+            Close(p[0]);
+            Close(p[1]);
+            free(pipes);
+            return -1;
+        }
+    }
+    int inner_end = ps->output ? p[0] : p[1];
+    subst[k].fd = ps->output ? p[1] : p[0];
+
+    for (int i = 0; i < nb_stages; i++) {
+        // Entrée et sortie : celles du shell, sauf le pipe de la substitution à son extrémité
+        int fd_in = (i > 0) ? pipes[2 * (i - 1)] : ps->output ? inner_end : STDIN_FILENO;
+        int fd_out = (i < nb_stages - 1) ? pipes[2 * i + 1] : ps->output ? STDOUT_FILENO : inner_end;
+
+        stage_builtin_t builtin = find_stage_builtin(ps->seq[i], 0);
+        pid_t pid = builtin ? -1 : spawn_simple_command(ps->seq[i], fd_in, fd_out, *pgid, mask, 0);
+        if (pid < 0) {
+            pid = Fork();
+            if (pid > 0)
+                TRACE(TRACE_FORK, pid, 0);
+        }
+        if (pid == 0) {
+            setup_forked_child(mask, *pgid);
+            setup_child_fds(fd_in, fd_out, l, subst, -1);
+            if (builtin != NULL)
+                execute_stage_builtin(builtin, ps->seq[i]);
+            execute_simple_command(ps->seq[i], STDIN_FILENO, STDOUT_FILENO);
+        }
+        if (*pgid == 0)
+            *pgid = pid;
+        TRACE(TRACE_SETPGID, pid, *pgid);
+        setpgid(pid, *pgid);
+        pids[(*nb_pids)++] = pid;
+        if (i > 0) {
+            Close(pipes[2 * (i - 1)]);
+            Close(pipes[2 * (i - 1) + 1]);
+        }
+    }
+    free(pipes);
+    Close(inner_end);
+    return 0;
+}
+
+/**
+ * @brief Abandon d'une ligne dont les substitutions sont déjà lancées (pipe impossible à créer) :
+ * ferme les extrémités restantes et termine le groupe, que sigchld_handler récoltera.
+ */
+static void substitution_cleanup(struct cmdline *l, subst_launch_t *subst, pid_t pgid) {
+    if (subst == NULL)
+        return;
+    for (int k = 0; k < l->nb_subst; k++)
+        if (subst[k].fd >= 0)
+            Close(subst[k].fd);
+    free(subst);
+    if (pgid > 0)
+        kill(-pgid, SIGTERM);
 }
 
 int execute_command_line(struct cmdline *l) {
+    struct timespec launch; // début du job : redirections ouvertes, juste avant le premier lancement
     int status = 0;
     int simple_cmds_nb = count_simple_commands(l);
-    pid_t* child_pids = malloc(simple_cmds_nb * sizeof(pid_t)); // tableau pour stocker les PID des processus enfants
+    int nb_inner = 0; // étapes des substitutions de processus, lancées avant la séquence
+    for (int k = 0; k < l->nb_subst; k++)
+        nb_inner += count_simple_commands(&(struct cmdline){ .seq = l->subst[k].seq });
+    pid_t* child_pids = malloc((nb_inner + simple_cmds_nb) * sizeof(pid_t)); // tableau pour stocker les PID des processus enfants
+    if (child_pids == NULL) {
+        // Rien n'est encore ouvert : ni redirection, ni pipe, ni substitution
+        perror("malloc");
+        return -1;
+    }
     int nb_cmds_executed = 0;
     pid_t pgid = 0; // ID de groupe de processus
 
@@ -215,10 +808,9 @@ int execute_command_line(struct cmdline *l) {
     build_cmdline_str(l, cmdline_str, sizeof(cmdline_str));
 
     /*
-     * Bloquer SIGCHLD :  un enfant ne peut pas terminer et mettre à jour la table avant que le parent appelle add_job.
+     * Pas de masquage de SIGCHLD : la fin d'un enfant n'est traitée que par events_wait, donc jamais avant add_job.
      */
-    sigset_t old_mask;
-    jobs_block_sigchld(&old_mask);
+    const sigset_t *child_mask = events_child_mask();
 
     // Ouverture des fichiers pour les redirections
     int fd_in = STDIN_FILENO; // descripteur pour le fichier d'entrée
@@ -226,20 +818,27 @@ int execute_command_line(struct cmdline *l) {
 
     int curr_fd_in;
     int curr_fd_out;
-    int* curr_pipe = NULL;
-    int* previous_pipe = NULL;
+    int nb_pipes = simple_cmds_nb - 1;
+    int* pipes = NULL; // tous les pipes de la séquence, alloués en une fois
 
     if (l->in) {
-        fd_in = open(l->in, O_RDONLY, 0644);
+        fd_in = open(l->in, O_RDONLY | O_CLOEXEC);
         if (fd_in < 0) {
             perror(l->in);
             parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, pgid);
             return 1;
         }
-    } 
+    } else if (l->in_data) {
+        fd_in = open_here_document(l->in_data, l->in_len);
+        if (fd_in < 0) {
+            perror("here-document");
+            free(child_pids);
+            return 1;
+        }
+    }
     // Sinon si c'est en background sans redirection explicite utiliser /dev/null
     else if (l->background) {
-        fd_in = open("/dev/null", O_RDONLY);
+        fd_in = get_devnull_fd();
         if (fd_in < 0) {
             perror("/dev/null");
             free(child_pids);
@@ -253,15 +852,16 @@ int execute_command_line(struct cmdline *l) {
      * redirection explicite n'est spécifiée.
      */
     if (l->background && !l->out && !isatty(STDOUT_FILENO)) {
-        fd_out = open("/dev/null", O_WRONLY);
+        fd_out = get_devnull_fd();
         if (fd_out < 0) {
             perror("/dev/null (stdout bg)");
+            close_redirection(fd_in, STDIN_FILENO);
             free(child_pids);
             return 1;
         }
     }
     if (l->out) {
-        int flags = O_WRONLY | O_CREAT;
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
         if (l->out_append) {
             flags |= O_APPEND; // Mode append (>>)
         } else {
@@ -275,103 +875,606 @@ int execute_command_line(struct cmdline *l) {
         }
     }
 
-    for (int i = 0; i < simple_cmds_nb; i++) {
+    // "cat < in [> out]" : copie dans le noyau par le shell lui-même, sans fork
+    if (is_redirection_copy(l, fd_in)) {
+        status = kernel_copy(fd_in, fd_out);
+        close_redirection(fd_in, STDIN_FILENO);
+        close_redirection(fd_out, STDOUT_FILENO);
+        free(child_pids);
+        return status;
+    }
 
-        if (!is_last_simple_command(l, i)) { // si ce n'est pas la dernière commande simple => il faut créer un pipe
-            curr_pipe = malloc(2 * sizeof(int));
-            if (curr_pipe == NULL) {
-                perror("malloc");
-                parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, pgid);
-                return -1;
-            }
-            if (pipe(curr_pipe) < 0) {
-                perror("pipe");
-                free(curr_pipe);
-                Close(previous_pipe[0]);
-                Close(previous_pipe[1]);
-                parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, pgid);
+    // Commande intégrée seule (echo, printf, true...) : exécutée dans le shell, sans fork
+    if (simple_cmds_nb == 1 && !l->background && l->nb_subst == 0) {
+        stage_builtin_t builtin = find_stage_builtin(l->seq[0], 1);
+        if (builtin != NULL) {
+            fflush(stdout);
+            status = builtin(l->seq[0], fd_in, fd_out);
+            close_redirection(fd_in, STDIN_FILENO);
+            close_redirection(fd_out, STDOUT_FILENO);
+            free(child_pids);
+            return status;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &launch);
+
+    // Substitutions de processus : lancées avant les pipes de la séquence (qu'elles n'héritent donc
+    // pas), dans le groupe du job que crée la première d'entre elles
+    subst_launch_t *subst = NULL;
+    int nb_launched = 0; // processus des substitutions lancés
+    if (l->nb_subst > 0) {
+        subst = Malloc(l->nb_subst * sizeof(subst_launch_t));
+        for (int k = 0; k < l->nb_subst; k++)
+            subst[k].fd = -1;
+        for (int k = 0; k < l->nb_subst; k++) {
+            if (spawn_substitution(l, k, subst, child_pids, &nb_launched, &pgid, child_mask) < 0) {
+                substitution_cleanup(l, subst, pgid);
+                parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, 0);
                 return -1;
             }
-            #ifdef DEBUG
-            DEBUG_PRINT("Created pipe, command %d: read : %d, write : %d\n", i, curr_pipe[0], curr_pipe[1]); 
-            #endif
+        }
+    }
+    pid_t *stage_pids = child_pids + nb_launched; // pid des étapes de la séquence
+
+    if (nb_pipes > 0) {
+        pipes = malloc(2 * nb_pipes * sizeof(int));
+        if (pipes == NULL) {
+            perror("malloc");
+            substitution_cleanup(l, subst, pgid);
+            parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, 0);
+            return -1;
+        }
+        if (create_pipes(pipes, nb_pipes) < 0) {
+            free(pipes);
+            substitution_cleanup(l, subst, pgid);
+            parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, 0);
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < simple_cmds_nb; i++) {
+
+        // Entrée : première commande simple => redirection d'entrée, sinon le dernier pipe
+        curr_fd_in = (i == 0) ? fd_in : pipes[2 * (i - 1)];
+        // Sortie : dernière commande simple => redirection de sortie, sinon le pipe courant
+        curr_fd_out = is_last_simple_command(l, i) ? fd_out : pipes[2 * i + 1];
+
+        // Arguments <(cmd) et >(cmd) de l'étape : remplacés par /dev/fd/N, hérité par cette étape seule
+        int extra_fds = 0;
+        for (int k = 0; k < l->nb_subst; k++) {
+            if (l->subst[k].stage != i)
+                continue;
+            subst[k].slot = l->seq[i];
+            while (*subst[k].slot != NULL && *subst[k].slot != l->subst[k].word)
+                subst[k].slot++;
+            if (*subst[k].slot == NULL) // argument retiré (préfixe) : pas de remplacement
+                continue;
+            fcntl(subst[k].fd, F_SETFD, 0);
+            snprintf(subst[k].path, sizeof(subst[k].path), "/dev/fd/%d", subst[k].fd);
+            *subst[k].slot = subst[k].path;
+            extra_fds = 1;
         }
 
-        child_pids[i] = Fork();
-        if (child_pids[i] == 0) {
+        // Commande intégrée d'étape : fork sans exec, sinon spawn de la commande externe
+        stage_builtin_t builtin = find_stage_builtin(l->seq[i], 0);
+        stage_pids[i] = builtin ? -1 : spawn_simple_command(l->seq[i], curr_fd_in, curr_fd_out, pgid, child_mask, extra_fds);
+        if (stage_pids[i] < 0) {
+            // Repli : chemin Fork() + execvp historique (commande introuvable, échec du spawn...)
+            stage_pids[i] = Fork();
+            if (stage_pids[i] > 0)
+                TRACE(TRACE_FORK, stage_pids[i], 0);
+        }
+        if (stage_pids[i] == 0) {
             #ifdef DEBUG
             DEBUG_PRINT("Child process %d created for command %d\n", getpid(), i); 
             #endif
 
-            // Restaurer le masque de signaux pour les enfants
-            jobs_unblock_sigchld(&old_mask);
-
-            // Restaurer les handlers de signaux par défaut dans les enfants
-            Signal(SIGINT, SIG_DFL);
-            Signal(SIGTSTP, SIG_DFL);
-            
-            // Gestion gpid
-            if (i == 0) {
-                // Premier processus : crée son propre groupe
-                setpgid(0, 0);
-            } else {
-                // Processus suivants : rejoindre le groupe du premier
-                setpgid(0, child_pids[0]);
-            }
-            
-            // Entrée
-            if (i == 0) { // première commande simple => redirection d'entrée
-                curr_fd_in = fd_in;
-            } else { // récup le dernier pipe
-                curr_fd_in = previous_pipe[0];
-                Close(previous_pipe[1]);
-            }
+            // Premier processus : crée son propre groupe, les suivants rejoignent le groupe du premier
+            setup_forked_child(child_mask, pgid);
+            setup_child_fds(curr_fd_in, curr_fd_out, l, subst, i);
 
-            // Sortie
-            if (is_last_simple_command(l, i)) { // dernière commande simple => redirection de sortie
-                curr_fd_out = fd_out;
-            } else {
-                curr_fd_out = curr_pipe[1];
-                Close(curr_pipe[0]);
-            }
-            execute_simple_command(l->seq[i], curr_fd_in, curr_fd_out);
+            if (builtin != NULL)
+                execute_stage_builtin(builtin, l->seq[i]);
+            execute_simple_command(l->seq[i], STDIN_FILENO, STDOUT_FILENO);
         }
         
         // Dans le parent : configurer le groupe de processus
-        if (i == 0) {
+        if (pgid == 0) {
             // Le premier enfant définit le pgid pour tout le job
-            pgid = child_pids[0];
-            setpgid(child_pids[0], pgid);
+            pgid = stage_pids[0];
+            TRACE(TRACE_SETPGID, stage_pids[0], pgid);
+            setpgid(stage_pids[0], pgid);
         } else {
             // Mettre les processus suivants dans le même groupe
-            setpgid(child_pids[i], pgid);
+            TRACE(TRACE_SETPGID, stage_pids[i], pgid);
+            setpgid(stage_pids[i], pgid);
+        }
+
+        // Extrémités des substitutions de l'étape : remettre les arguments d'origine, fermer dans le shell
+        for (int k = 0; k < l->nb_subst; k++) {
+            if (l->subst[k].stage == i) {
+                if (*subst[k].slot != NULL)
+                    *subst[k].slot = l->subst[k].word;
+                Close(subst[k].fd);
+                subst[k].fd = -1;
+            }
         }
         
         nb_cmds_executed++;
-        if (previous_pipe) {
-            Close(previous_pipe[0]);
-            Close(previous_pipe[1]);
-            free(previous_pipe);
+        // Le pipe entre la commande i-1 et la commande i n'est plus utile au parent
+        if (i > 0) {
+            Close(pipes[2 * (i - 1)]);
+            Close(pipes[2 * (i - 1) + 1]);
         }
-        previous_pipe = curr_pipe;
-        curr_pipe = NULL;
     }
+    free(pipes);
+    free(subst);
+    struct timespec spawned; // posix_spawn ne rend la main qu'après l'exec de l'étape
+    clock_gettime(CLOCK_MONOTONIC, &spawned);
 
     // Ajouter le job dans la table 
     if (pgid > 0) {
         job_state_t initial_state = l->background ? JOB_RUNNING : JOB_FOREGROUND;
-        int jid = add_job(pgid, initial_state, cmdline_str);
+        int jid = add_job(pgid, initial_state, cmdline_str, child_pids, nb_launched + nb_cmds_executed);
         #ifdef DEBUG
         DEBUG_PRINT("Added job jid=%d pgid=%d state=%d cmdline='%s'\n", jid, (int)pgid, initial_state, cmdline_str);
         #endif
+        if (jid > 0) {
+            last_launched = get_job_by_jid(jid);
+            last_launched->start = launch;
+            last_launched->spawned = spawned;
+        }
         if (l->background && jid > 0) { // On affiche immédiatement l'info du job si en background
             printf("[%d] %d\n", jid, (int)pgid);
         }
     }
 
-    // la table est à jour => débloquer SIGCHLD maintenant 
-    jobs_unblock_sigchld(&old_mask);
-
     parent_cleanup(fd_in, fd_out, l->background, child_pids, nb_cmds_executed, &status, pgid);
     return status;
 }
+
+pid_t launch_background_command(char **argv, int fd_in, int fd_out, job_done_hook_t on_done) {
+    const sigset_t *child_mask = events_child_mask();
+
+    // Ligne de commande pour la table de jobs
+    char cmdline_str[MAXCMDLEN];
+    cmdline_str[0] = '\0';
+    for (int j = 0; argv[j] != NULL; j++) {
+        if (j > 0)
+            strncat(cmdline_str, " ", sizeof(cmdline_str) - strlen(cmdline_str) - 1);
+        strncat(cmdline_str, argv[j], sizeof(cmdline_str) - strlen(cmdline_str) - 1);
+    }
+
+    stage_builtin_t builtin = find_stage_builtin(argv, 0);
+    pid_t pid = builtin ? -1 : spawn_simple_command(argv, fd_in, fd_out, 0, child_mask, 0);
+    if (pid < 0) {
+        pid = Fork();
+        if (pid > 0)
+            TRACE(TRACE_FORK, pid, 0);
+        if (pid == 0) {
+            setup_forked_child(child_mask, 0);
+            setup_child_fds(fd_in, fd_out, NULL, NULL, 0);
+            if (builtin != NULL)
+                execute_stage_builtin(builtin, argv);
+            execute_simple_command(argv, STDIN_FILENO, STDOUT_FILENO);
+        }
+        TRACE(TRACE_SETPGID, pid, pid);
+        setpgid(pid, pid);
+    }
+
+    int jid = add_job(pid, JOB_RUNNING, cmdline_str, &pid, 1);
+    if (jid < 0) {
+        // Table des jobs non agrandie (mémoire) : le job ne sera pas vu par sigchld_handler, on l'attend ici
+        int status;
+        if (waitpid(pid, &status, 0) == pid && on_done != NULL)
+            on_done(pid, status);
+        return -1;
+    }
+    set_job_done_hook(jid, on_done);
+    return pid;
+}
+
+/**
+ * @brief Exécute "étapes | parallel ..." : parallel est une commande intégrée, pas une étape de la séquence.
+ * Les étapes précédentes sont exécutées au premier plan, sortie dans un memfd, puis parallel y lit ses
+ * arguments comme dans un "< fichier". parallel lit de toute façon tous ses arguments avant de lancer la
+ * première instance ; un pipe lu seulement après la fin des étapes les bloquerait dès qu'il est plein.
+ * @param c La ligne de commande
+ * @param n Son nombre d'étapes (au moins 2, la dernière étant parallel)
+ * @return int Le code de retour de parallel, ou celui des étapes si elles ont été suspendues ou tuées
+ */
+static int execute_parallel_pipeline(struct cmdline *c, int n) {
+    int fd = memfd_create("parallel", MFD_CLOEXEC);
+    if (fd < 0) {
+        perror("parallel: memfd_create");
+        return 1;
+    }
+    char path[32];
+    snprintf(path, sizeof(path), "/dev/fd/%d", fd);
+
+    // Étapes précédentes, avec leurs substitutions de processus (en tête : ordre des arguments)
+    struct cmdline producer = *c;
+    char **parallel_args = c->seq[n - 1];
+    c->seq[n - 1] = NULL;
+    producer.out = path;
+    producer.out_append = 0;
+    producer.background = 0;
+    producer.nb_subst = 0;
+    while (producer.nb_subst < c->nb_subst && c->subst[producer.nb_subst].stage < n - 1)
+        producer.nb_subst++;
+    last_launched = NULL;
+    int status = execute_command_line(&producer);
+    c->seq[n - 1] = parallel_args;
+
+    // Étapes suspendues (Ctrl+Z) ou tuées (Ctrl+C) : arguments incomplets, aucune instance lancée
+    job_t *j = last_launched;
+    if (j != NULL && (j->state != JOB_DONE || WIFSIGNALED(j->status))) {
+        if (j->state != JOB_DONE)
+            fprintf(stderr, "parallel: étapes précédentes suspendues, aucune instance lancée\n");
+        Close(fd);
+        return status;
+    }
+
+    struct cmdline parallel_cmd = { .seq = c->seq + n - 1, .in = path, .out = c->out, .out_append = c->out_append };
+    status = builtin_parallel(&parallel_cmd);
+    Close(fd);
+    return status;
+}
+
+/**
+ * @brief Exécute une ligne de commande : commande intégrée, sinon séquence de commandes avec pipes.
+ */
+static int run_line(struct cmdline *c) {
+    TRACE(TRACE_EXECUTE_BEGIN, 0, 0);
+    int n = count_simple_commands(c);
+    int status;
+    if (n > 1 && c->seq[n - 1][0] != NULL && strcmp(c->seq[n - 1][0], "parallel") == 0)
+        status = execute_parallel_pipeline(c, n);
+    else if ((status = execute_builtin(c)) == -1)
+        status = execute_command_line(c);
+    TRACE(TRACE_EXECUTE_END, status, 0);
+    return status;
+}
+
+/**
+ * @brief Exécute une ligne de commande préfixée par time (c->seq[0][0] == "time") et rend compte des
+ * ressources consommées : tout de suite sur la sortie d'erreur si elle s'est terminée au premier plan,
+ * sinon par une notification à la fin du job (arrière-plan ou job suspendu).
+ * Sans job lancé (commande intégrée exécutée dans le shell), le rapport porte sur le shell et les
+ * enfants qu'il a récoltés pendant la commande (time wait...).
+ * @param c La ligne de commande
+ * @return int Le code de retour de la commande
+ */
+static int execute_timed(struct cmdline *c) {
+    struct timespec start, end;
+    struct rusage self0, self1, children0, children1;
+    int status = 0;
+
+    c->seq[0]++; // retirer le mot "time"
+    last_launched = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    getrusage(RUSAGE_SELF, &self0);
+    getrusage(RUSAGE_CHILDREN, &children0);
+    if (c->seq[0][0] != NULL)
+        status = run_line(c);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    job_t *j = last_launched;
+    if (j != NULL) {
+        if (j->state == JOB_DONE) {
+            char *report = job_times_report(j);
+            fflush(stdout);
+            fputs(report, stderr);
+            free(report);
+        } else {
+            j->timed = 1;
+        }
+        return status;
+    }
+
+    getrusage(RUSAGE_SELF, &self1);
+    getrusage(RUSAGE_CHILDREN, &children1);
+    fflush(stdout);
+    fprintf(stderr, "time:%s%s\n", c->seq[0][0] != NULL ? " " : "", c->seq[0][0] != NULL ? c->seq[0][0] : "");
+    print_usage_line(stderr, "  total",
+                     timespec_diff(&end, &start),
+                     timeval_diff(&self1.ru_utime, &self0.ru_utime) + timeval_diff(&children1.ru_utime, &children0.ru_utime),
+                     timeval_diff(&self1.ru_stime, &self0.ru_stime) + timeval_diff(&children1.ru_stime, &children0.ru_stime),
+                     self1.ru_maxrss > children1.ru_maxrss ? self1.ru_maxrss : children1.ru_maxrss,
+                     (self1.ru_nvcsw - self0.ru_nvcsw) + (children1.ru_nvcsw - children0.ru_nvcsw),
+                     (self1.ru_nivcsw - self0.ru_nivcsw) + (children1.ru_nivcsw - children0.ru_nivcsw));
+    return status;
+}
+
+/* Préfixe bench : exécutions répétées et percentiles de latence */
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Affiche min, p50, p90, p99 et max (en µs) d'une série de mesures, triée sur place.
+ * Les mesures négatives (indisponibles : commande intégrée exécutée dans le shell) sont ignorées.
+ */
+static void print_percentiles(const char *label, double *v, int n) {
+    int width = 12;
+    for (const char *c = label; *c; c++)
+        if ((*c & 0xC0) == 0x80)
+            width++;
+    qsort(v, n, sizeof(double), compare_double);
+    int first = 0;
+    while (first < n && v[first] < 0)
+        first++;
+    v += first;
+    n -= first;
+    if (n == 0) {
+        printf("%-*s %10s\n", width, label, "-");
+        return;
+    }
+    // Percentile au rang le plus proche : plus petite mesure telle que p % des mesures lui sont inférieures ou égales
+    double p50 = v[(n * 50 + 99) / 100 - 1], p90 = v[(n * 90 + 99) / 100 - 1], p99 = v[(n * 99 + 99) / 100 - 1];
+    printf("%-*s %10.1f %10.1f %10.1f %10.1f %10.1f\n", width, label, v[0] * 1e6, p50 * 1e6, p90 * 1e6, p99 * 1e6, v[n - 1] * 1e6);
+}
+
+/**
+ * @brief Lit le nombre entier positif ou nul arg (option opt du préfixe prefix).
+ * @return int Le nombre, -1 s'il est invalide (message affiché)
+ */
+static int parse_count(const char *prefix, const char *opt, const char *arg) {
+    char *end;
+    long v = arg != NULL ? strtol(arg, &end, 10) : -1;
+    if (arg == NULL || end == arg || *end != '\0' || v < 0 || v > INT_MAX) {
+        fprintf(stderr, "%s: %s: nombre invalide: %s\n", prefix, opt, arg != NULL ? arg : "");
+        return -1;
+    }
+    return (int)v;
+}
+
+#define BENCH_MAX_RUNS 1000000 /* Mesures gardées en mémoire : 24 Mo au plus */
+
+/**
+ * @brief Exécute une ligne de commande préfixée par bench [-n N] [-w W] [-o fichier.csv] : W exécutions
+ * d'échauffement, puis N exécutions mesurées, par le chemin habituel (execute_command_line, ou la
+ * commande intégrée). Affiche min, p50, p90, p99 et max du temps total, du temps du lancement
+ * jusqu'à l'exec de toutes les étapes (fork-exec, redirections déjà ouvertes) et de l'exec à la fin de
+ * la dernière étape (exec-fin). Au plus BENCH_MAX_RUNS exécutions mesurées.
+ * Avec -o, chaque exécution mesurée est aussi écrite dans un fichier CSV.
+ * Un Ctrl+C (exécution tuée par SIGINT) arrête la série.
+ * @param c La ligne de commande (c->seq[0][0] == "bench")
+ * @return int Le code de retour de la dernière exécution, 2 en cas d'erreur d'utilisation
+ */
+static int execute_bench(struct cmdline *c) {
+    char **args = c->seq[0];
+    int runs = 10, warmup = 0;
+    const char *csv_path = NULL;
+    int i = 1;
+
+    for (; args[i] != NULL && args[i][0] == '-'; i++) {
+        if (strcmp(args[i], "-n") == 0) {
+            if ((runs = parse_count("bench", "-n", args[++i])) < 0)
+                return 2;
+        } else if (strcmp(args[i], "-w") == 0) {
+            if ((warmup = parse_count("bench", "-w", args[++i])) < 0)
+                return 2;
+        } else if (strcmp(args[i], "-o") == 0) {
+            if ((csv_path = args[++i]) == NULL) {
+                fprintf(stderr, "usage: bench [-n N] [-w W] [-o fichier.csv] commande [arg ...]\n");
+                return 2;
+            }
+        } else {
+            break;
+        }
+    }
+    if (runs > BENCH_MAX_RUNS) {
+        fprintf(stderr, "bench: -n: au plus %d exécutions\n", BENCH_MAX_RUNS);
+        return 2;
+    }
+    if (args[i] == NULL || runs == 0) {
+        fprintf(stderr, "usage: bench [-n N] [-w W] [-o fichier.csv] commande [arg ...]\n");
+        return 2;
+    }
+    if (c->background) {
+        fprintf(stderr, "bench: pas de mesure en arrière-plan\n");
+        return 2;
+    }
+    c->seq[0] += i; // retirer "bench" et ses options
+
+    FILE *csv = NULL;
+    if (csv_path != NULL) {
+        if ((csv = fopen(csv_path, "we")) == NULL) {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(csv, "run,total_us,fork_exec_us,exec_exit_us,status\n");
+    }
+
+    double *total = Malloc(3 * (size_t)runs * sizeof(double));
+    double *fork_exec = total + runs, *exec_exit = total + 2 * runs;
+    int status = 0, nb_runs = 0, nb_failures = 0;
+
+    for (int run = -warmup; run < runs; run++) {
+        struct timespec start, end;
+        last_launched = NULL;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status = run_line(c);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (status == 128 + SIGINT) // Ctrl+C : arrêter la série
+            break;
+        if (run < 0)
+            continue;
+
+        job_t *j = last_launched;
+        total[run] = timespec_diff(&end, &start);
+        fork_exec[run] = exec_exit[run] = -1;
+        if (j != NULL && j->state == JOB_DONE) {
+            const struct timespec *last = &j->spawned;
+            for (int k = 0; k < j->nb_procs; k++)
+                if (timespec_diff(&j->procs[k].end, last) > 0)
+                    last = &j->procs[k].end;
+            fork_exec[run] = timespec_diff(&j->spawned, &j->start);
+            exec_exit[run] = timespec_diff(last, &j->spawned);
+        }
+        if (status != 0)
+            nb_failures++;
+        nb_runs++;
+        if (csv != NULL) { // champs vides si la mesure n'est pas disponible
+            fprintf(csv, "%d,%.1f,", run + 1, total[run] * 1e6);
+            if (fork_exec[run] >= 0)
+                fprintf(csv, "%.1f,%.1f", fork_exec[run] * 1e6, exec_exit[run] * 1e6);
+            else
+                fprintf(csv, ",");
+            fprintf(csv, ",%d\n", status);
+        }
+    }
+    if (csv != NULL)
+        fclose(csv);
+
+    char cmdline_str[MAXCMDLEN];
+    build_cmdline_str(c, cmdline_str, sizeof(cmdline_str));
+    printf("bench: %s : %d exécutions (%d d'échauffement), %d échecs\n", cmdline_str, nb_runs, warmup, nb_failures);
+    if (nb_runs > 0) {
+        printf("%-13s %10s %10s %10s %10s %10s\n", "(µs)" /* µ : 2 octets */, "min", "p50", "p90", "p99", "max");
+        print_percentiles("total", total, nb_runs);
+        print_percentiles("fork-exec", fork_exec, nb_runs);
+        print_percentiles("exec-fin", exec_exit, nb_runs);
+    }
+    fflush(stdout);
+    free(total);
+    return status;
+}
+
+/* Préfixe cache : résultats des commandes déterministes */
+
+/**
+ * @brief Exécute une ligne de commande préfixée par cache [--ttl S] : si une entrée du cache
+ * correspond (même ligne, même fichier d'entrée, même répertoire et environnement, et pas plus
+ * vieille que S secondes), sa sortie est rejouée sans lancer la commande. Sinon la ligne est
+ * exécutée par execute_command_line avec une étape tee ajoutée en fin de séquence, qui recopie
+ * la sortie dans une nouvelle entrée ; le code de retour de la dernière étape d'origine y est
+ * enregistré si elle s'est terminée normalement au premier plan.
+ * Seule la sortie standard est conservée. En arrière-plan, la ligne est exécutée sans cache.
+ * Sans commande, affiche l'état du cache ; cache --clear le vide.
+ * @param c La ligne de commande (c->seq[0][0] == "cache")
+ * @return int Le code de retour de la commande (enregistré en cas de succès du cache), 2 en cas
+ * d'erreur d'utilisation
+ */
+static int execute_cached(struct cmdline *c) {
+    char **args = c->seq[0];
+    long ttl = -1;
+    int i = 1;
+
+    if (args[1] == NULL) {
+        cache_print_status();
+        return 0;
+    }
+    if (strcmp(args[1], "--clear") == 0) {
+        if (args[2] != NULL) {
+            fprintf(stderr, "usage: cache [--ttl secondes] commande [arg ...] | cache --clear\n");
+            return 2;
+        }
+        int nb_removed = cache_clear();
+        if (nb_removed < 0)
+            return 1;
+        printf("cache: %d fichier(s) supprimé(s)\n", nb_removed);
+        return 0;
+    }
+    if (strcmp(args[1], "--ttl") == 0) {
+        if ((ttl = parse_count("cache", "--ttl", args[2])) < 0)
+            return 2;
+        i = 3;
+    }
+    if (args[i] == NULL) {
+        fprintf(stderr, "usage: cache [--ttl secondes] commande [arg ...] | cache --clear\n");
+        return 2;
+    }
+    c->seq[0] += i; // retirer "cache" et ses options
+
+    uint64_t key;
+    if (c->background || cache_key(c, &key) < 0)
+        return execute_command_line(c); // redirection d'entrée illisible : message habituel
+
+    int status;
+    int fd = cache_open(key, ttl, &status);
+    if (fd >= 0) {
+        int fd_out = STDOUT_FILENO;
+        if (c->out != NULL) {
+            fd_out = open(c->out, O_WRONLY | O_CREAT | O_CLOEXEC | (c->out_append ? O_APPEND : O_TRUNC), 0644);
+            if (fd_out < 0) {
+                perror(c->out);
+                close(fd);
+                return 1;
+            }
+        }
+        fflush(stdout);
+        if (kernel_copy(fd, fd_out) != 0)
+            status = 1;
+        close(fd);
+        if (fd_out != STDOUT_FILENO)
+            close(fd_out);
+        return status;
+    }
+
+    char *tmp = cache_begin();
+    if (tmp == NULL)
+        return execute_command_line(c);
+
+    // Séquence d'origine suivie de "tee -a tmp", qui reçoit la redirection de sortie
+    int n = 0;
+    while (c->seq[n] != NULL)
+        n++;
+    char *tee[] = { "tee", "-a", tmp, NULL };
+    char ***seq = Malloc((n + 2) * sizeof(char **));
+    memcpy(seq, c->seq, n * sizeof(char **));
+    seq[n] = tee;
+    seq[n + 1] = NULL;
+
+    char ***orig_seq = c->seq;
+    c->seq = seq;
+    last_launched = NULL;
+    status = execute_command_line(c);
+    c->seq = orig_seq;
+    free(seq);
+
+    job_t *j = last_launched;
+    // Dernière étape d'origine : l'avant-dernier processus du job (les substitutions sont en tête)
+    int last_status = j != NULL && j->state == JOB_DONE && j->nb_procs >= n + 1 ? j->procs[j->nb_procs - 2].status : -1;
+    // Commande suspendue, tuée par un signal ou introuvable : rien n'est enregistré
+    if (last_status >= 0 && WIFEXITED(last_status) && WEXITSTATUS(last_status) != 127) {
+        status = WEXITSTATUS(last_status);
+        cache_commit(tmp, key, status);
+    } else {
+        if (last_status >= 0)
+            status = exit_code_of(last_status);
+        cache_abort(tmp);
+    }
+    return status;
+}
+
+int execute_command_sequence(struct cmdline *l) {
+    int status = 0;
+    struct cmdline *c = l;
+
+    while (c != NULL) {
+        if (c->seq[0] != NULL && c->seq[0][0] != NULL && strcmp(c->seq[0][0], "time") == 0) {
+            status = execute_timed(c);
+        } else if (c->seq[0] != NULL && c->seq[0][0] != NULL && strcmp(c->seq[0][0], "bench") == 0) {
+            status = execute_bench(c);
+        } else if (c->seq[0] != NULL && c->seq[0][0] != NULL && strcmp(c->seq[0][0], "cache") == 0) {
+            status = execute_cached(c);
+        } else {
+            status = run_line(c);
+        }
+
+        // Ignorer les lignes dont la condition (&& / ||) n'est pas remplie, comme bash :
+        // dans "a && b || c", si a échoue, b est sauté et c est exécutée.
+        int op = c->next_op;
+        c = c->next;
+        while (c != NULL && ((op == SEQ_AND && status != 0) || (op == SEQ_OR && status == 0))) {
+            op = c->next_op;
+            c = c->next;
+        }
+    }
+    return status;
+}
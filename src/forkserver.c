@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include "csapp.h"
+#include "forkserver.h"
+
+#define FORKSERVER_MSG_MAX (64 * 1024) /* Au-delà, lancement par posix_spawn */
+#define FORKSERVER_NB_FDS  3           /* Entrée, sortie et erreur de la commande */
+
+/**
+ * @brief En-tête d'une demande, suivi du chemin et des arguments, chacun terminé par '\0'.
+ */
+typedef struct {
+    int32_t  pgid;
+    uint32_t size; /* Taille des chaînes qui suivent */
+} request_t;
+
+/**
+ * @brief Réponse de l'auxiliaire.
+ */
+typedef struct {
+    int32_t pid; /* Pid de la commande, -errno si le clone a échoué */
+    int32_t err; /* 0, ou errno de l'échec de setpgid ou de l'exec */
+} reply_t;
+
+static int server_fd = -1; // côté shell, -1 si pas d'auxiliaire
+
+/* Signaux ignorés par l'auxiliaire (il est dans le groupe du shell, qui reçoit Ctrl+C au prompt) */
+static const int ignored_signals[] = { SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU };
+
+int forkserver_start(const char *exe) {
+    int sv[2];
+    char fd_str[16];
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0)
+        return -1;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        // Espace d'adressage neuf : ré-exécuter le shell en mode auxiliaire
+        int fd = dup(sv[1]); // sans O_CLOEXEC
+        snprintf(fd_str, sizeof(fd_str), "%d", fd);
+        execl("/proc/self/exe", exe, "--fork-server", fd_str, (char *)NULL);
+        execl(exe, exe, "--fork-server", fd_str, (char *)NULL);
+        _exit(127);
+    }
+    close(sv[1]);
+    server_fd = sv[0];
+    return 0;
+}
+
+#define FORKSERVER_STACK (64 * 1024) /* Pile de la commande jusqu'à son exec */
+
+/**
+ * @brief Paramètres de la commande, partagés avec l'auxiliaire (CLONE_VM).
+ */
+typedef struct {
+    char      *path;
+    char     **argv;
+    const int *fds;
+    pid_t      pgid;
+    int        err; /* errno de l'échec de setpgid, dup2 ou exec, 0 sinon */
+} launch_t;
+
+/**
+ * @brief Dans la commande : groupe, descripteurs, signaux, puis exec. L'auxiliaire est suspendu
+ * (CLONE_VFORK) jusqu'à l'exec ou jusqu'à _exit, et lit alors l'éventuel errno dans launch->err.
+ */
+static int exec_command(void *arg) {
+    launch_t *launch = arg;
+
+    for (size_t i = 0; i < sizeof(ignored_signals) / sizeof(ignored_signals[0]); i++)
+        signal(ignored_signals[i], SIG_DFL);
+    if (setpgid(0, launch->pgid) == 0 && dup2(launch->fds[0], STDIN_FILENO) >= 0 &&
+        dup2(launch->fds[1], STDOUT_FILENO) >= 0 && dup2(launch->fds[2], STDERR_FILENO) >= 0) {
+        // Descripteurs reçus et socket déjà O_CLOEXEC ; restent ceux hérités du shell au démarrage
+        close_range(STDERR_FILENO + 1, ~0U, 0);
+        execv(launch->path, launch->argv);
+    }
+    launch->err = errno;
+    _exit(127);
+}
+
+/**
+ * @brief Traite une demande : crée la commande comme enfant du shell (CLONE_PARENT) et attend son exec.
+ */
+static reply_t serve(char *path, char **argv, const int *fds, pid_t pgid) {
+    static char stack[FORKSERVER_STACK] __attribute__((aligned(16)));
+    launch_t launch = { .path = path, .argv = argv, .fds = fds, .pgid = pgid, .err = 0 };
+    reply_t reply;
+
+    // SIGCHLD : la fin de la commande est signalée à son parent, le shell
+    pid_t pid = clone(exec_command, stack + sizeof(stack), CLONE_PARENT | CLONE_VM | CLONE_VFORK | SIGCHLD, &launch);
+    reply.pid = pid < 0 ? -errno : pid;
+    reply.err = pid < 0 ? 0 : launch.err;
+    return reply;
+}
+
+void forkserver_main(int fd) {
+    static char buf[sizeof(request_t) + FORKSERVER_MSG_MAX];
+    static char *argv[FORKSERVER_MSG_MAX / 2 + 1];
+    char control[CMSG_SPACE(FORKSERVER_NB_FDS * sizeof(int))];
+
+    prctl(PR_SET_NAME, "shell-forksrv");
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() == 1) // Shell déjà terminé
+        _exit(0);
+    for (size_t i = 0; i < sizeof(ignored_signals) / sizeof(ignored_signals[0]); i++)
+        signal(ignored_signals[i], SIG_IGN);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    for (;;) {
+        struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+        struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control) };
+        ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) // Shell terminé
+            _exit(0);
+
+        int fds[FORKSERVER_NB_FDS];
+        int nb_fds = 0;
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            nb_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), nb_fds * sizeof(int));
+        }
+
+        reply_t reply = { .pid = -EINVAL, .err = 0 };
+        request_t *req = (request_t *)buf;
+        if (nb_fds == FORKSERVER_NB_FDS && (size_t)n >= sizeof(request_t) && req->size == n - sizeof(request_t)) {
+            // Chaînes : chemin puis arguments
+            char *s = buf + sizeof(request_t), *end = s + req->size;
+            char *path = s;
+            int argc = 0;
+            s += strnlen(s, end - s) + 1;
+            while (s < end) {
+                argv[argc++] = s;
+                s += strnlen(s, end - s) + 1;
+            }
+            argv[argc] = NULL;
+            if (argc > 0)
+                reply = serve(path, argv, fds, req->pgid);
+        }
+        for (int i = 0; i < nb_fds; i++)
+            close(fds[i]);
+        if (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) < 0)
+            _exit(0);
+    }
+}
+
+int forkserver_spawn(pid_t *pid, const char *path, char *const argv[], int fd_in, int fd_out, pid_t pgid) {
+    static char buf[sizeof(request_t) + FORKSERVER_MSG_MAX];
+    char control[CMSG_SPACE(FORKSERVER_NB_FDS * sizeof(int))];
+    request_t *req = (request_t *)buf;
+    size_t size = 0;
+
+    if (server_fd < 0)
+        return -1;
+
+    // Chemin puis arguments, chacun terminé par '\0'
+    const char *s = path;
+    for (int i = -1; s != NULL; s = argv[++i]) {
+        size_t len = strlen(s) + 1;
+        if (size + len > FORKSERVER_MSG_MAX)
+            return -1;
+        memcpy(buf + sizeof(request_t) + size, s, len);
+        size += len;
+    }
+    req->pgid = pgid;
+    req->size = size;
+
+    struct iovec iov = { .iov_base = buf, .iov_len = sizeof(request_t) + size };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control) };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    int fds[FORKSERVER_NB_FDS] = { fd_in, fd_out, STDERR_FILENO };
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    reply_t reply;
+    ssize_t n;
+    while ((n = sendmsg(server_fd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR)
+        ;
+    if (n >= 0)
+        while ((n = recv(server_fd, &reply, sizeof(reply), 0)) < 0 && errno == EINTR)
+            ;
+    if (n != sizeof(reply)) { // Auxiliaire terminé : plus de serveur, retour à posix_spawn
+        close(server_fd);
+        server_fd = -1;
+        return -1;
+    }
+    if (reply.pid <= 0) // Clone impossible dans l'auxiliaire
+        return -1;
+    *pid = reply.pid;
+    return reply.err;
+}
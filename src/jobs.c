@@ -1,176 +1,565 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <sys/pidfd.h>
+#include <sys/resource.h>
 #include "csapp.h"
 #include "jobs.h"
+#include "trace.h"
 
-static job_t job_table[MAXJOBS];
+/*
+ * Table des jobs sans limite de taille :
+ *   - les jobs sont alloués par blocs de taille doublée à chaque fois, jamais libérés ; les cases
+ *     libres sont chaînées (par pgid_next) dans une liste de cases libres ;
+ *   - trois index par hachage : pgid et jid (chaînés dans les jobs), pid de chaque étape (chaîné
+ *     dans les processus, tableau propre à chaque case et conservé quand la case est recyclée) ;
+ *   - une liste doublement chaînée par jid croissant : le plus grand jid est la queue ;
+ *   - le job au premier plan et le nombre de jobs en arrière-plan sont tenus à jour à chaque
+ *     changement d'état ;
+ *   - chaque processus a un pidfd tant qu'il n'est pas récolté (attente par wait), et celui du chef
+ *     de groupe est gardé jusqu'au retrait du job : il désigne le groupe pour job_signal.
+ * La table n'est utilisée que dans le contexte normal du shell : sigchld_handler est appelé par la
+ * boucle d'événements, jamais de façon asynchrone. Un job terminé passe à JOB_DONE et est empilé,
+ * puis retiré par add_job : un job_t * obtenu avant une attente (events_wait) reste lisible ensuite.
+ */
+#define JOBS_MIN_CHUNK   64
+#define JOBS_MIN_BUCKETS 64
+
+#ifndef PIDFD_SIGNAL_PROCESS_GROUP
+#define PIDFD_SIGNAL_PROCESS_GROUP (1UL << 2) /* Linux >= 6.9 */
+#endif
+
+static job_t *free_jobs = NULL;        // cases libres
+static size_t next_chunk = JOBS_MIN_CHUNK;
+static job_t **pgid_index = NULL;
+static job_t **jid_index = NULL;
+static proc_t **pid_index = NULL;
+static size_t nb_buckets = 0;          // puissance de 2
+static size_t nb_jobs = 0;
+static size_t nb_procs = 0;            // processus de tous les jobs de la table
+static job_t *first_job = NULL;        // liste par jid croissant
+static job_t *last_job = NULL;
+static job_t *fg_job = NULL;           // job JOB_FOREGROUND, NULL si aucun
+static int nb_background = 0;          // jobs JOB_RUNNING ou JOB_STOPPED
+static job_t *done_jobs = NULL;        // pile des jobs JOB_DONE à retirer (chaînés par done_next)
+static size_t nb_pidfds = 0;
+static size_t pidfd_budget = 0;        // au plus la moitié des descripteurs autorisés
+static unsigned long masks_avoided = 0; // appels sigprocmask évités
+
+static size_t pgid_bucket(pid_t pgid) {
+    return ((unsigned long)pgid * 2654435761u) & (nb_buckets - 1);
+}
+
+static size_t pid_bucket(pid_t pid) {
+    return ((unsigned long)pid * 2654435761u) & (nb_buckets - 1);
+}
+
+static size_t jid_bucket(int jid) {
+    return (size_t)jid & (nb_buckets - 1); // jid consécutifs : répartition régulière
+}
+
+static int is_background(job_state_t state) {
+    return state == JOB_RUNNING || state == JOB_STOPPED;
+}
 
 /**
- * @brief Retourne l'indice de la première case libre, -1 si le tableau est plein.
+ * @brief Ouvre un pidfd sur pid, dans la limite du budget : au-delà, ou si le noyau ne connaît pas
+ * pidfd_open, le processus est désigné par son pid (-1).
  */
-static int first_free_slot(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid == 0)
-            return i;
+static int open_pidfd(pid_t pid) {
+    if (nb_pidfds >= pidfd_budget)
+        return -1;
+    int fd = pidfd_open(pid, 0); // toujours O_CLOEXEC
+    if (fd >= 0)
+        nb_pidfds++;
+    return fd;
+}
+
+static void close_pidfd(proc_t *p) {
+    if (p->pidfd >= 0) {
+        close(p->pidfd);
+        nb_pidfds--;
+        p->pidfd = -1;
     }
-    return -1;
 }
 
 /**
- * @brief Détermine le plus petit jid disponible (>= 1).
+ * @brief Ajoute un bloc de cases libres.
+ * @return 0 si succès, -1 si la mémoire manque.
  */
-static int next_jid(void) {
-    int max = 0;
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid > max)
-            max = job_table[i].jid;
+static int grow_free_list(void) {
+    job_t *chunk = calloc(next_chunk, sizeof(job_t));
+    if (chunk == NULL)
+        return -1;
+    for (size_t i = 0; i < next_chunk; i++) {
+        chunk[i].pgid_next = free_jobs;
+        free_jobs = &chunk[i];
     }
-    return max + 1;
+    next_chunk *= 2;
+    return 0;
 }
 
+/**
+ * @brief Double le nombre de seaux des trois index et y replace tous les jobs et processus.
+ * @return 0 si succès, -1 si la mémoire manque (les index sont alors inchangés).
+ */
+static int grow_indexes(void) {
+    size_t new_size = nb_buckets ? 2 * nb_buckets : JOBS_MIN_BUCKETS;
+    job_t **new_pgid = calloc(new_size, sizeof(job_t *));
+    job_t **new_jid = calloc(new_size, sizeof(job_t *));
+    proc_t **new_pid = calloc(new_size, sizeof(proc_t *));
+    if (new_pgid == NULL || new_jid == NULL || new_pid == NULL) {
+        free(new_pgid);
+        free(new_jid);
+        free(new_pid);
+        return -1;
+    }
 
-void jobs_init(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        job_table[i].jid   = 0;
-        job_table[i].pgid  = 0;
-        job_table[i].state = JOB_UNDEF;
-        job_table[i].cmdline[0] = '\0';
+    free(pgid_index);
+    free(jid_index);
+    free(pid_index);
+    pgid_index = new_pgid;
+    jid_index = new_jid;
+    pid_index = new_pid;
+    nb_buckets = new_size;
+    for (job_t *j = first_job; j != NULL; j = j->next) {
+        size_t b = pgid_bucket(j->pgid);
+        j->pgid_next = pgid_index[b];
+        pgid_index[b] = j;
+        b = jid_bucket(j->jid);
+        j->jid_next = jid_index[b];
+        jid_index[b] = j;
+        for (int i = 0; i < j->nb_procs; i++) {
+            b = pid_bucket(j->procs[i].pid);
+            j->procs[i].pid_next = pid_index[b];
+            pid_index[b] = &j->procs[i];
+        }
     }
+    return 0;
 }
 
-void jobs_block_sigchld(sigset_t *old_mask) {
-    sigset_t mask;
-    Sigemptyset(&mask);
-    Sigaddset(&mask, SIGCHLD);
-    Sigprocmask(SIG_BLOCK, &mask, old_mask);
+/**
+ * @brief Tient à jour le job au premier plan et le compte des jobs en arrière-plan après une transition.
+ */
+static void account_transition(job_t *j, job_state_t from, job_state_t to) {
+    int delta = is_background(to) - is_background(from);
+    nb_background += delta;
+    if (to == JOB_FOREGROUND)
+        fg_job = j;
+    else if (from == JOB_FOREGROUND && fg_job == j)
+        fg_job = NULL;
 }
 
-void jobs_unblock_sigchld(const sigset_t *old_mask) {
-    Sigprocmask(SIG_SETMASK, old_mask, NULL);
-}
+int job_transition(job_t *j, unsigned from, job_state_t to) {
+    job_state_t cur = j->state;
 
-int add_job(pid_t pgid, job_state_t state, const char *cmdline) {
-    int slot = first_free_slot();
-    if (slot < 0) {
-        fprintf(stderr, "jobs: table pleine (MAXJOBS = %d)\n", MAXJOBS);
+    if (!(from & JOB_MASK(cur)))
         return -1;
+    j->state = to;
+    account_transition(j, cur, to);
+    return cur;
+}
+
+/**
+ * @brief Retire un job des index et de la liste, puis remet sa case dans les cases libres.
+ */
+static void remove_job(job_t *j) {
+    job_t **p;
+
+    TRACE(TRACE_JOB_DELETE, j->jid, j->pgid);
+    for (p = &pgid_index[pgid_bucket(j->pgid)]; *p != j; p = &(*p)->pgid_next)
+        ;
+    *p = j->pgid_next;
+    for (p = &jid_index[jid_bucket(j->jid)]; *p != j; p = &(*p)->jid_next)
+        ;
+    *p = j->jid_next;
+    for (int i = 0; i < j->nb_procs; i++) {
+        proc_t **q;
+        for (q = &pid_index[pid_bucket(j->procs[i].pid)]; *q != &j->procs[i]; q = &(*q)->pid_next)
+            ;
+        *q = j->procs[i].pid_next;
+        close_pidfd(&j->procs[i]);
     }
+    nb_procs -= j->nb_procs;
+    j->nb_procs = 0;
 
-    job_table[slot].jid   = next_jid();
-    job_table[slot].pgid  = pgid;
-    job_table[slot].state = state;
-    strncpy(job_table[slot].cmdline, cmdline, MAXCMDLEN - 1);
-    job_table[slot].cmdline[MAXCMDLEN - 1] = '\0';
+    if (j->prev)
+        j->prev->next = j->next;
+    else
+        first_job = j->next;
+    if (j->next)
+        j->next->prev = j->prev;
+    else
+        last_job = j->prev;
 
-    return job_table[slot].jid;
+    account_transition(j, j->state, JOB_UNDEF);
+    j->state = JOB_UNDEF;
+    nb_jobs--;
+    j->jid = 0;
+    j->pgid = 0;
+    j->cmdline[0] = '\0';
+    j->on_done = NULL;
+    j->done_next = NULL;
+    j->jid_next = NULL;
+    j->prev = j->next = NULL;
+    j->pgid_next = free_jobs;
+    free_jobs = j;
 }
 
-int delete_job_by_jid(int jid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid == jid) {
-            job_table[i].jid   = 0;
-            job_table[i].pgid  = 0;
-            job_table[i].state = JOB_UNDEF;
-            job_table[i].cmdline[0] = '\0';
-            return 0;
-        }
+/**
+ * @brief Retire de la table tous les jobs marqués JOB_DONE par sigchld_handler.
+ */
+static void reap_done_jobs(void) {
+    job_t *j = done_jobs;
+    done_jobs = NULL;
+    while (j != NULL) {
+        job_t *next = j->done_next;
+        remove_job(j);
+        j = next;
     }
-    return -1;
 }
 
-int delete_job_by_pgid(pid_t pgid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].pgid == pgid && job_table[i].jid != 0) {
-            job_table[i].jid   = 0;
-            job_table[i].pgid  = 0;
-            job_table[i].state = JOB_UNDEF;
-            job_table[i].cmdline[0] = '\0';
-            return 0;
-        }
+
+void jobs_init(void) {
+    struct rlimit rl;
+
+    // Le reste des descripteurs pour les redirections et les pipes
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+        pidfd_budget = rl.rlim_cur / 2;
+    else
+        pidfd_budget = 1 << 20;
+    free_jobs = NULL;
+    next_chunk = JOBS_MIN_CHUNK;
+    first_job = last_job = NULL;
+    fg_job = NULL;
+    done_jobs = NULL;
+    nb_jobs = 0;
+    nb_background = 0;
+    nb_procs = 0;
+    masks_avoided = 0;
+    free(pgid_index);
+    free(jid_index);
+    free(pid_index);
+    pgid_index = jid_index = NULL;
+    pid_index = NULL;
+    nb_buckets = 0;
+    if (grow_indexes() < 0)
+        unix_error("jobs_init");
+}
+
+int add_job(pid_t pgid, job_state_t state, const char *cmdline, const pid_t *pids, int nb_pids) {
+    jobs_mask_avoided(); // lancement + ajout : autrefois SIGCHLD bloqué pendant tout le spawn
+    // Les jobs terminés ne comptent plus pour le jid suivant
+    reap_done_jobs();
+
+    if (free_jobs == NULL && grow_free_list() < 0)
+        goto nomem;
+    while (nb_jobs >= nb_buckets || nb_procs + nb_pids > nb_buckets) {
+        if (grow_indexes() < 0)
+            goto nomem;
+    }
+
+    job_t *j = free_jobs;
+    if (j->procs_capacity < nb_pids) {
+        // La case est libre : son tableau de processus n'est dans aucun index
+        proc_t *procs = realloc(j->procs, nb_pids * sizeof(proc_t));
+        if (procs == NULL)
+            goto nomem;
+        j->procs = procs;
+        j->procs_capacity = nb_pids;
+    }
+    free_jobs = j->pgid_next;
+
+    j->jid   = last_job ? last_job->jid + 1 : 1;
+    j->pgid  = pgid;
+    j->status = 0;
+    j->state = state;
+    account_transition(j, JOB_UNDEF, state);
+    strncpy(j->cmdline, cmdline, MAXCMDLEN - 1);
+    j->cmdline[MAXCMDLEN - 1] = '\0';
+    j->on_done = NULL;
+    j->timed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &j->start);
+    j->spawned = j->start;
+
+    j->nb_procs = nb_pids;
+    j->nb_alive = nb_pids;
+    nb_procs += nb_pids;
+    for (int i = 0; i < nb_pids; i++) {
+        proc_t *p = &j->procs[i];
+        p->pid = pids[i];
+        p->state = PROC_RUNNING;
+        p->status = 0;
+        p->end.tv_sec = p->end.tv_nsec = 0;
+        memset(&p->rusage, 0, sizeof(p->rusage));
+        p->job = j;
+        p->pidfd = open_pidfd(p->pid); // pas encore récolté : le pid ne peut pas avoir été réattribué
+        size_t b = pid_bucket(p->pid);
+        p->pid_next = pid_index[b];
+        pid_index[b] = p;
     }
+
+    size_t b = pgid_bucket(pgid);
+    j->pgid_next = pgid_index[b];
+    pgid_index[b] = j;
+    b = jid_bucket(j->jid);
+    j->jid_next = jid_index[b];
+    jid_index[b] = j;
+
+    j->prev = last_job;
+    j->next = NULL;
+    if (last_job)
+        last_job->next = j;
+    else
+        first_job = j;
+    last_job = j;
+    nb_jobs++;
+
+    TRACE(TRACE_JOB_ADD, j->jid, pgid);
+    return j->jid;
+
+nomem:
+    fprintf(stderr, "jobs: mémoire insuffisante pour agrandir la table\n");
     return -1;
 }
 
+int set_job_done_hook(int jid, job_done_hook_t on_done) {
+    job_t *j = get_job_by_jid(jid);
+    if (j == NULL)
+        return -1;
+    j->on_done = on_done;
+    return 0;
+}
+
+int delete_job_by_jid(int jid) {
+    job_t *j = get_job_by_jid(jid);
+    if (j == NULL)
+        return -1;
+    remove_job(j);
+    return 0;
+}
+
+int delete_job_by_pgid(pid_t pgid) {
+    job_t *j = get_job_by_pgid(pgid);
+    if (j == NULL)
+        return -1;
+    remove_job(j);
+    return 0;
+}
+
 
 job_t *get_job_by_jid(int jid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid == jid)
-            return &job_table[i];
+    if (jid <= 0 || nb_buckets == 0)
+        return NULL;
+    for (job_t *j = jid_index[jid_bucket(jid)]; j != NULL; j = j->jid_next) {
+        if (j->jid == jid && j->state != JOB_DONE)
+            return j;
     }
     return NULL;
 }
 
 job_t *get_job_by_pgid(pid_t pgid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].pgid == pgid && job_table[i].jid != 0)
-            return &job_table[i];
+    if (pgid <= 0 || nb_buckets == 0)
+        return NULL;
+    for (job_t *j = pgid_index[pgid_bucket(pgid)]; j != NULL; j = j->pgid_next) {
+        if (j->pgid == pgid && j->state != JOB_DONE)
+            return j;
     }
     return NULL;
 }
 
-job_t *get_fg_job(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].state == JOB_FOREGROUND && job_table[i].jid != 0)
-            return &job_table[i];
+proc_t *get_proc_by_pid(pid_t pid) {
+    if (pid <= 0 || nb_buckets == 0)
+        return NULL;
+    for (proc_t *p = pid_index[pid_bucket(pid)]; p != NULL; p = p->pid_next) {
+        if (p->pid == pid && p->state != PROC_DONE && p->job->state != JOB_DONE)
+            return p;
     }
     return NULL;
 }
 
+job_t *get_fg_job(void) {
+    return fg_job;
+}
+
+job_t *get_next_job(job_t *j) {
+    j = j != NULL ? j->next : first_job;
+    while (j != NULL && j->state == JOB_DONE)
+        j = j->next;
+    return j;
+}
+
+job_t *get_current_job(void) {
+    job_t *j = last_job;
+    while (j != NULL && !(JOB_MASK(j->state) & (JOB_MASK(JOB_RUNNING) | JOB_MASK(JOB_STOPPED))))
+        j = j->prev;
+    return j;
+}
+
 job_t *resolve_job_arg(const char *arg) {
     if (arg == NULL)
         return NULL;
 
     if (arg[0] == '%') {
-        // Désignation par numéro de job : %N 
+        // Désignation par numéro de job : %N
         int jid = atoi(arg + 1);
         return get_job_by_jid(jid);
     } else {
-        // Désignation par PID (= pgid du groupe) 
-        pid_t pgid = (pid_t)atoi(arg);
-        return get_job_by_pgid(pgid);
+        // Désignation par PID : pgid du groupe, ou pid de n'importe quelle étape
+        pid_t pid = (pid_t)atoi(arg);
+        job_t *j = get_job_by_pgid(pid);
+        if (j == NULL) {
+            proc_t *p = get_proc_by_pid(pid);
+            j = p != NULL ? p->job : NULL;
+        }
+        return j;
     }
 }
 
 int set_job_state(int jid, job_state_t state) {
     job_t *j = get_job_by_jid(jid);
-    if (j == NULL)
+    if (j == NULL || job_transition(j, JOB_ACTIVE_MASK, state) < 0)
         return -1;
-    j->state = state;
     return 0;
 }
 
 int set_job_state_by_pgid(pid_t pgid, job_state_t state) {
     job_t *j = get_job_by_pgid(pgid);
-    if (j == NULL)
+    if (j == NULL || job_transition(j, JOB_ACTIVE_MASK, state) < 0)
         return -1;
-    j->state = state;
     return 0;
 }
 
+void mark_proc_stopped(proc_t *p) {
+    if (p->state == PROC_RUNNING)
+        p->state = PROC_STOPPED;
+}
+
+int mark_proc_done(proc_t *p, int status, const struct rusage *ru) {
+    job_t *j = p->job;
+
+    p->status = status;
+    if (ru != NULL)
+        p->rusage = *ru;
+    clock_gettime(CLOCK_MONOTONIC, &p->end);
+    if (p != &j->procs[0]) // le pidfd du chef désigne le groupe jusqu'au retrait du job
+        close_pidfd(p);
+    if (p->state != PROC_DONE) {
+        p->state = PROC_DONE;
+        if (--j->nb_alive > 0)
+            return -1;
+        // Dernier processus du job : le statut du job est celui de la dernière étape, comme pour un shell
+        return mark_job_done(j, j->procs[j->nb_procs - 1].status);
+    }
+    return -1;
+}
+
+void mark_job_continued(job_t *j) {
+    for (int i = 0; i < j->nb_procs; i++) {
+        if (j->procs[i].state == PROC_STOPPED)
+            j->procs[i].state = PROC_RUNNING;
+    }
+}
+
+int job_signal(job_t *j, int sig) {
+    int pidfd = j->procs[0].pidfd;
+
+    if (pidfd >= 0) {
+        if (pidfd_send_signal(pidfd, sig, NULL, PIDFD_SIGNAL_PROCESS_GROUP) == 0)
+            return 0;
+        if (errno != EINVAL) // EINVAL : drapeau inconnu du noyau
+            return -1;
+    }
+    // Repli sur kill : le pgid ne peut pas être réattribué tant qu'un processus du job n'est pas récolté
+    if (j->nb_alive == 0) {
+        errno = ESRCH;
+        return -1;
+    }
+    return kill(-j->pgid, sig);
+}
+
+int job_pidfds(job_t *j, int *fds) {
+    int n = 0;
+    for (int i = 0; i < j->nb_procs; i++) {
+        if (j->procs[i].pidfd >= 0 && j->procs[i].state != PROC_DONE)
+            fds[n++] = j->procs[i].pidfd;
+    }
+    return n;
+}
+
+int mark_job_stopped(job_t *j) {
+    return job_transition(j, JOB_MASK(JOB_FOREGROUND) | JOB_MASK(JOB_RUNNING), JOB_STOPPED);
+}
+
+int mark_job_done(job_t *j, int status) {
+    j->status = status;
+    int prev = job_transition(j, JOB_ACTIVE_MASK, JOB_DONE);
+    if (prev >= 0) {
+        // Empiler pour add_job : le job reste lisible par qui l'attendait
+        j->done_next = done_jobs;
+        done_jobs = j;
+    }
+    return prev;
+}
+
 
 const char *job_state_str(job_state_t state) {
     switch (state) {
         case JOB_FOREGROUND: return "Foreground";
         case JOB_RUNNING: return "Running";
         case JOB_STOPPED: return "Stopped";
+        case JOB_DONE: return "Done";
         default: return "Unknown";
     }
 }
 
-void list_jobs(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid != 0) {
-            printf("[%d] %d %-10s %s\n", job_table[i].jid, (int)job_table[i].pgid, job_state_str(job_table[i].state), job_table[i].cmdline);
-        }
+static const char *proc_state_str(proc_state_t state) {
+    switch (state) {
+        case PROC_RUNNING: return "Running";
+        case PROC_STOPPED: return "Stopped";
+        default: return "Done";
     }
 }
 
-int has_running_jobs(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (job_table[i].jid != 0 &&
-            (job_table[i].state == JOB_RUNNING || job_table[i].state == JOB_STOPPED))
-            return 1;
+/**
+ * @brief Affiche le détail d'une étape : pid, état, et pour une étape terminée son statut et sa durée.
+ */
+static void print_proc(const proc_t *p, const struct timespec *start) {
+    proc_state_t state = p->state;
+    if (state != PROC_DONE) {
+        printf("    %d %s\n", (int)p->pid, proc_state_str(state));
+        return;
     }
-    return 0;
+
+    double elapsed = (p->end.tv_sec - start->tv_sec) + (p->end.tv_nsec - start->tv_nsec) * 1e-9;
+    printf("    %d %-10s ", (int)p->pid, proc_state_str(state));
+    if (WIFSIGNALED(p->status))
+        printf("signal %-3d", WTERMSIG(p->status));
+    else
+        printf("exit %-5d", WEXITSTATUS(p->status));
+    printf(" %.3fs\n", elapsed);
+}
+
+void list_jobs(int long_format) {
+    for (job_t *j = first_job; j != NULL; j = j->next) {
+        job_state_t state = j->state;
+        if (state == JOB_DONE)
+            continue;
+        printf("[%d] %d %-10s %s\n", j->jid, (int)j->pgid, job_state_str(state), j->cmdline);
+        for (int i = 0; long_format && i < j->nb_procs; i++)
+            print_proc(&j->procs[i], &j->start);
+    }
+}
+
+void jobs_mask_avoided(void) {
+    masks_avoided += 2;
+}
+
+void jobs_print_stats(void) {
+    printf("sigprocmask évités   : %lu\n", masks_avoided);
+}
+
+int has_running_jobs(void) {
+    return nb_background > 0;
 }
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <sys/uio.h>
+#include "csapp.h"
+#include "notify.h"
+
+/*
+ * Anneau de notifications : un seul producteur (sigchld_handler) et un seul consommateur
+ * (notify_flush), tous deux dans le contexte normal du shell depuis la boucle d'événements :
+ * aucun verrou ni opération atomique n'est nécessaire. La taille est celle d'un writev (IOV_MAX).
+ */
+#define NOTIFY_RING 1024
+
+typedef struct {
+    char  *text;
+    size_t len;
+} notice_t;
+
+static notice_t ring[NOTIFY_RING];
+static unsigned int head = 0; // prochaine notification à écrire
+static unsigned int tail = 0; // prochaine case libre (tail - head notifications en attente)
+static int immediate = 0;
+
+static unsigned long nb_notices = 0;
+static unsigned long nb_writev = 0;
+
+/**
+ * @brief Écrit iov en entier sur la sortie standard, en reprenant après une écriture partielle.
+ */
+static void write_all(struct iovec *iov, int nb_iov) {
+    while (nb_iov > 0) {
+        ssize_t n = writev(STDOUT_FILENO, iov, nb_iov);
+        nb_writev++;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return; // sortie fermée : les notifications sont perdues, comme avec printf
+        }
+        while (nb_iov > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            nb_iov--;
+        }
+        if (nb_iov > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+void notify_flush(void) {
+    struct iovec iov[NOTIFY_RING];
+    int nb_iov = 0;
+
+    if (head == tail)
+        return;
+    fflush(stdout);
+    for (unsigned int i = head; i != tail; i++) {
+        notice_t *n = &ring[i % NOTIFY_RING];
+        iov[nb_iov++] = (struct iovec){ .iov_base = n->text, .iov_len = n->len };
+    }
+    write_all(iov, nb_iov);
+    for (; head != tail; head++) {
+        free(ring[head % NOTIFY_RING].text);
+        ring[head % NOTIFY_RING].text = NULL;
+    }
+}
+
+void notify_job(const char *fmt, ...) {
+    va_list ap;
+    char *text;
+    int len;
+
+    va_start(ap, fmt);
+    len = vasprintf(&text, fmt, ap);
+    va_end(ap);
+    if (len < 0)
+        unix_error("vasprintf");
+
+    if (tail - head == NOTIFY_RING)
+        notify_flush();
+    ring[tail % NOTIFY_RING] = (notice_t){ .text = text, .len = len };
+    tail++;
+    nb_notices++;
+}
+
+void notify_end_batch(void) {
+    if (immediate)
+        notify_flush();
+}
+
+void notify_set_immediate(int on) {
+    immediate = on;
+    if (on)
+        notify_flush();
+}
+
+int notify_is_immediate(void) {
+    return immediate;
+}
+
+void notify_print_stats(void) {
+    printf("notifications        : %lu\n", nb_notices);
+    printf("appels à writev      : %lu\n", nb_writev);
+}
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "csapp.h"
+#include "events.h"
+#include "execute.h"
+#include "jobs.h"
+#include "parallel.h"
+
+/**
+ * @brief Une instance de la commande (un argument d'entrée).
+ */
+typedef struct {
+    pid_t                 pgid;
+    int                   out_fd;    /* Sortie capturée (-k), -1 si la sortie est directe */
+    int                   done;      /* Mis à 1 par sigchld_handler */
+    int                   status;    /* Statut waitpid de l'instance */
+    int                   collected; /* Fin déjà prise en compte par la boucle principale */
+} parallel_task_t;
+
+/* État de l'exécution en cours, partagé avec parallel_task_done */
+static parallel_task_t *tasks = NULL;
+static int *slots = NULL;     /* slots[k] : indice de la tâche occupant le slot k, -1 si libre */
+static int nb_slots = 0;
+static int orphan_status = 0; /* Statut d'une instance absente de la table des jobs */
+static int interrupted = 0;   /* SIGINT ou SIGTERM reçu pendant l'exécution, 0 sinon */
+
+/**
+ * @brief Fonction de fin de job (appelée depuis events_wait) : marque l'instance correspondante comme terminée.
+ */
+static void parallel_task_done(pid_t pgid, int status) {
+    for (int k = 0; k < nb_slots; k++) {
+        if (slots[k] >= 0 && tasks[slots[k]].pgid == pgid) {
+            tasks[slots[k]].status = status;
+            tasks[slots[k]].done = 1;
+            return;
+        }
+    }
+    orphan_status = status; // instance attendue directement par launch_background_command
+}
+
+/**
+ * @brief Traitant de SIGINT et SIGTERM pendant l'exécution (appelé depuis events_wait) : les instances
+ * sont dans leurs propres groupes, en arrière-plan, et ne reçoivent pas le Ctrl+C du terminal.
+ * Le signal leur est retransmis et plus aucune instance n'est lancée.
+ */
+static void parallel_interrupt(int signum) {
+    interrupted = signum;
+    for (int k = 0; k < nb_slots; k++) {
+        if (slots[k] < 0 || tasks[slots[k]].done)
+            continue;
+        job_t *j = get_job_by_pgid(tasks[slots[k]].pgid);
+        if (j != NULL)
+            job_signal(j, signum);
+    }
+}
+
+/**
+ * @brief Construit la commande d'une instance : chaque "{}" est remplacé par arg,
+ * et arg est ajouté à la fin si le modèle ne contient aucun "{}".
+ * @param tmpl Le modèle de commande (terminé par NULL)
+ * @param arg L'argument de l'instance
+ * @return char** La commande (terminée par NULL), chaque chaîne étant allouée.
+ */
+static char **expand_template(char **tmpl, const char *arg) {
+    int n = 0, has_placeholder = 0;
+    size_t arg_len = strlen(arg);
+
+    while (tmpl[n] != NULL) {
+        if (strstr(tmpl[n], "{}") != NULL)
+            has_placeholder = 1;
+        n++;
+    }
+
+    char **argv = Malloc((n + 2) * sizeof(char *));
+    for (int i = 0; i < n; i++) {
+        const char *src = tmpl[i];
+        size_t len = strlen(src) + 1;
+        for (const char *p = strstr(src, "{}"); p != NULL; p = strstr(p + 2, "{}"))
+            len += arg_len - 2;
+
+        char *dst = Malloc(len);
+        char *d = dst;
+        const char *p;
+        while ((p = strstr(src, "{}")) != NULL) {
+            memcpy(d, src, p - src);
+            d += p - src;
+            memcpy(d, arg, arg_len);
+            d += arg_len;
+            src = p + 2;
+        }
+        strcpy(d, src);
+        argv[i] = dst;
+    }
+    if (!has_placeholder)
+        argv[n++] = strdup(arg);
+    argv[n] = NULL;
+    return argv;
+}
+
+static void free_argv(char **argv) {
+    for (int i = 0; argv[i] != NULL; i++)
+        Free(argv[i]);
+    Free(argv);
+}
+
+/**
+ * @brief Ajoute une copie de item au tableau d'arguments (les lignes vides sont ignorées).
+ */
+static void add_item(char ***items, int *nb_items, const char *item) {
+    if (item[0] == '\0')
+        return;
+    *items = Realloc(*items, (*nb_items + 1) * sizeof(char *));
+    (*items)[(*nb_items)++] = strdup(item);
+}
+
+/**
+ * @brief Lit les arguments (une ligne par argument) depuis un flux.
+ * @param f Le flux à lire
+ * @param items Tableau d'arguments à compléter (réalloué)
+ * @param nb_items Nombre d'arguments du tableau (mis à jour)
+ */
+static void read_items(FILE *f, char ***items, int *nb_items) {
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, f)) >= 0) {
+        if (len > 0 && line[len - 1] == '\n')
+            line[--len] = '\0';
+        add_item(items, nb_items, line);
+    }
+    free(line);
+}
+
+/**
+ * @brief Recopie la sortie capturée d'une instance vers out_fd puis la libère.
+ */
+static void flush_task_output(parallel_task_t *t, int out_fd) {
+    char buf[MAXBUF];
+    ssize_t n;
+
+    lseek(t->out_fd, 0, SEEK_SET);
+    while ((n = read(t->out_fd, buf, sizeof(buf))) > 0) {
+        if (write(out_fd, buf, n) != n) {
+            perror("parallel: write");
+            break;
+        }
+    }
+    Close(t->out_fd);
+    t->out_fd = -1;
+}
+
+int builtin_parallel(struct cmdline *cmd) {
+    char **args = cmd->seq[0];
+    long njobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int keep_order = 0;
+    const char *arg_file = cmd->in;
+    int i = 1;
+
+    // Options
+    for (; args[i] != NULL && args[i][0] == '-'; i++) {
+        if (strcmp(args[i], "-k") == 0) {
+            keep_order = 1;
+        } else if (strcmp(args[i], "-j") == 0 && args[i + 1] != NULL) {
+            char *end;
+            njobs = strtol(args[++i], &end, 10);
+            if (end == args[i] || *end != '\0' || njobs < 1 || njobs > INT_MAX) {
+                fprintf(stderr, "parallel: -j: nombre invalide: %s\n", args[i]);
+                fprintf(stderr, "usage: parallel [-j N] [-k] [-a fichier] commande [arg ...] [::: arg ...]\n");
+                return 2;
+            }
+        } else if (strcmp(args[i], "-a") == 0 && args[i + 1] != NULL) {
+            arg_file = args[++i];
+        } else {
+            fprintf(stderr, "parallel: option invalide: %s\n", args[i]);
+            fprintf(stderr, "usage: parallel [-j N] [-k] [-a fichier] commande [arg ...] [::: arg ...]\n");
+            return 2;
+        }
+    }
+    if (njobs < 1)
+        njobs = 1;
+
+    // Modèle de commande, jusqu'à ":::" éventuel
+    int tmpl_start = i;
+    while (args[i] != NULL && strcmp(args[i], ":::") != 0)
+        i++;
+    if (i == tmpl_start) {
+        fprintf(stderr, "usage: parallel [-j N] [-k] [-a fichier] commande [arg ...] [::: arg ...]\n");
+        return 2;
+    }
+    int tmpl_len = i - tmpl_start;
+    char **tmpl = Malloc((tmpl_len + 1) * sizeof(char *));
+    memcpy(tmpl, args + tmpl_start, tmpl_len * sizeof(char *));
+    tmpl[tmpl_len] = NULL;
+
+    // Arguments : après ":::", sinon dans le fichier (-a, "<" ou la sortie de l'étape précédente) ou le here-document
+    char **items = NULL;
+    int nb_items = 0;
+    if (args[i] != NULL) {
+        for (i++; args[i] != NULL; i++)
+            add_item(&items, &nb_items, args[i]);
+    } else if (arg_file != NULL) {
+        FILE *f = fopen(arg_file, "re");
+        if (f == NULL) {
+            perror(arg_file);
+            Free(tmpl);
+            return 2;
+        }
+        read_items(f, &items, &nb_items);
+        fclose(f);
+    } else if (cmd->in_data != NULL && cmd->in_len > 0) {
+        // Here-document ou here-string
+        FILE *f = fmemopen(cmd->in_data, cmd->in_len, "r");
+        if (f == NULL) {
+            perror("parallel: fmemopen");
+            Free(tmpl);
+            return 2;
+        }
+        read_items(f, &items, &nb_items);
+        fclose(f);
+    } else {
+        // Pas l'entrée du shell : ce serait la suite du script ou du terminal
+        fprintf(stderr, "parallel: aucun argument (::: arg ..., -a fichier, < fichier ou commande | parallel)\n");
+        Free(tmpl);
+        return 2;
+    }
+
+    // Entrée des instances : /dev/null, sortie : "> fichier" ou la sortie standard
+    int null_fd = get_devnull_fd();
+    int out_fd = STDOUT_FILENO;
+    if (cmd->out) {
+        out_fd = open(cmd->out, O_WRONLY | O_CREAT | O_CLOEXEC | (cmd->out_append ? O_APPEND : O_TRUNC), 0644);
+        if (out_fd < 0) {
+            perror(cmd->out);
+            out_fd = STDOUT_FILENO;
+        }
+    }
+    fflush(stdout);
+
+    tasks = Calloc(nb_items > 0 ? nb_items : 1, sizeof(parallel_task_t));
+    nb_slots = njobs < nb_items ? njobs : nb_items;
+    slots = Malloc((nb_slots > 0 ? nb_slots : 1) * sizeof(int));
+    for (int k = 0; k < nb_slots; k++)
+        slots[k] = -1;
+
+    int next = 0, running = 0, flushed = 0;
+    int succeeded = 0, failed = 0;
+
+    // Ctrl+C et SIGTERM retransmis aux instances le temps de l'exécution
+    interrupted = 0;
+    event_handler_t prev_sigint = events_on_signal(SIGINT, parallel_interrupt);
+    event_handler_t prev_sigterm = events_on_signal(SIGTERM, parallel_interrupt);
+    jobs_mask_avoided(); // la boucle d'attente n'a plus à bloquer SIGCHLD
+
+    while ((next < nb_items && !interrupted) || running > 0) {
+        // Occuper tous les slots libres
+        for (int k = 0; k < nb_slots && next < nb_items && !interrupted; k++) {
+            if (slots[k] >= 0)
+                continue;
+            parallel_task_t *t = &tasks[next];
+            t->out_fd = -1;
+            if (keep_order) {
+                t->out_fd = memfd_create("parallel", MFD_CLOEXEC);
+                if (t->out_fd < 0)
+                    perror("parallel: memfd_create");
+            }
+
+            char **argv = expand_template(tmpl, items[next]);
+            slots[k] = next;
+            orphan_status = 0;
+            pid_t pgid = launch_background_command(argv, null_fd, t->out_fd >= 0 ? t->out_fd : out_fd, parallel_task_done);
+            free_argv(argv);
+            if (pgid < 0) { // instance déjà terminée et attendue
+                t->status = orphan_status;
+                t->done = 1;
+            }
+            t->pgid = pgid;
+            running++;
+            next++;
+        }
+
+        // Prendre en compte les instances terminées (signalées par sigchld_handler)
+        int collected = 0;
+        for (int k = 0; k < nb_slots; k++) {
+            if (slots[k] < 0 || !tasks[slots[k]].done)
+                continue;
+            parallel_task_t *t = &tasks[slots[k]];
+            t->collected = 1;
+            if (WIFEXITED(t->status) && WEXITSTATUS(t->status) == 0)
+                succeeded++;
+            else
+                failed++;
+            slots[k] = -1;
+            running--;
+            collected++;
+        }
+
+        // -k : restituer les sorties dans l'ordre des entrées
+        while (keep_order && flushed < next && tasks[flushed].collected) {
+            if (tasks[flushed].out_fd >= 0)
+                flush_task_output(&tasks[flushed], out_fd);
+            flushed++;
+        }
+
+        if (collected == 0 && running > 0)
+            events_wait(-1);
+    }
+
+    events_on_signal(SIGINT, prev_sigint);
+    events_on_signal(SIGTERM, prev_sigterm);
+
+    fprintf(stderr, "parallel: %d succeeded, %d failed\n", succeeded, failed);
+    int status = failed == 0 ? 0 : 1;
+    if (interrupted) {
+        fprintf(stderr, "parallel: interrompu, %d argument(s) non traité(s)\n", nb_items - next);
+        status = 128 + interrupted;
+    }
+
+    if (out_fd != STDOUT_FILENO)
+        Close(out_fd);
+    for (int k = 0; k < nb_items; k++)
+        Free(items[k]);
+    free(items);
+    Free(tmpl);
+    Free(tasks);
+    Free(slots);
+    tasks = NULL;
+    slots = NULL;
+    nb_slots = 0;
+
+    return status;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "csapp.h"
+#include "pathcache.h"
+
+#define PATHCACHE_BUCKETS 64
+
+/**
+ * @brief Entrée du cache : nom de commande => chemin résolu.
+ */
+typedef struct pathcache_entry {
+    char                   *name;
+    char                   *path;
+    unsigned long           hits;
+    struct pathcache_entry *next;
+} pathcache_entry_t;
+
+static pathcache_entry_t *buckets[PATHCACHE_BUCKETS];
+static char *cached_path_env = NULL; // valeur de PATH au moment du remplissage du cache
+static char *uncached_path = NULL;   // dernier chemin trouvé par une entrée relative de PATH (non mis en cache)
+
+/**
+ * @brief Fonction de hachage FNV-1a sur le nom de la commande.
+ */
+static unsigned int hash_name(const char *name) {
+    unsigned int h = 2166136261u;
+    for (; *name; name++) {
+        h ^= (unsigned char)*name;
+        h *= 16777619u;
+    }
+    return h % PATHCACHE_BUCKETS;
+}
+
+/**
+ * @brief Vide le cache si PATH a changé depuis le dernier remplissage.
+ */
+static void check_path_env(void) {
+    const char *env = getenv("PATH");
+    if (env == NULL)
+        env = "";
+    if (cached_path_env != NULL && strcmp(cached_path_env, env) == 0)
+        return;
+    pathcache_reset();
+    cached_path_env = strdup(env);
+}
+
+/**
+ * @brief Parcourt PATH à la recherche d'un fichier régulier exécutable nommé name.
+ * @return Le chemin trouvé (alloué avec malloc), NULL sinon.
+ */
+static char *resolve_in_path(const char *name) {
+    const char *dir = cached_path_env;
+    size_t name_len = strlen(name);
+
+    while (dir != NULL) {
+        const char *end = strchr(dir, ':');
+        size_t dir_len = end ? (size_t)(end - dir) : strlen(dir);
+        char *candidate = Malloc(dir_len + name_len + 3);
+        struct stat st;
+
+        if (dir_len == 0) { // entrée vide dans PATH => répertoire courant
+            strcpy(candidate, "./");
+        } else {
+            memcpy(candidate, dir, dir_len);
+            candidate[dir_len] = '/';
+            candidate[dir_len + 1] = '\0';
+        }
+        strcat(candidate, name);
+
+        if (stat(candidate, &st) == 0 && S_ISREG(st.st_mode) && access(candidate, X_OK) == 0)
+            return candidate;
+        Free(candidate);
+        dir = end ? end + 1 : NULL;
+    }
+    return NULL;
+}
+
+const char *pathcache_lookup(const char *name) {
+    if (name == NULL || name[0] == '\0')
+        return NULL;
+    if (strchr(name, '/') != NULL) // chemin explicite : pas de recherche dans PATH
+        return name;
+
+    check_path_env();
+
+    unsigned int h = hash_name(name);
+    for (pathcache_entry_t *e = buckets[h]; e != NULL; e = e->next) {
+        if (strcmp(e->name, name) == 0) {
+            e->hits++;
+            return e->path;
+        }
+    }
+
+    char *path = resolve_in_path(name);
+    if (path == NULL)
+        return NULL;
+
+    // Entrée de PATH vide ou relative ("", ".", "bin") : le résultat dépend du répertoire courant.
+    // Rendu absolu (valable aussi pour le serveur de lancement) mais pas mis en cache.
+    if (path[0] != '/') {
+        char cwd[PATH_MAX];
+        free(uncached_path);
+        uncached_path = NULL;
+        if (getcwd(cwd, sizeof(cwd)) != NULL) {
+            uncached_path = Malloc(strlen(cwd) + strlen(path) + 2);
+            sprintf(uncached_path, "%s/%s", cwd, path);
+        }
+        Free(path);
+        return uncached_path;
+    }
+
+    pathcache_entry_t *e = Malloc(sizeof(pathcache_entry_t));
+    e->name = strdup(name);
+    e->path = path;
+    e->hits = 1;
+    e->next = buckets[h];
+    buckets[h] = e;
+    return e->path;
+}
+
+int pathcache_forget(const char *name) {
+    pathcache_entry_t **prev = &buckets[hash_name(name)];
+    for (pathcache_entry_t *e = *prev; e != NULL; prev = &e->next, e = e->next) {
+        if (strcmp(e->name, name) == 0) {
+            *prev = e->next;
+            Free(e->name);
+            Free(e->path);
+            Free(e);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void pathcache_reset(void) {
+    for (int i = 0; i < PATHCACHE_BUCKETS; i++) {
+        pathcache_entry_t *e = buckets[i];
+        while (e != NULL) {
+            pathcache_entry_t *next = e->next;
+            Free(e->name);
+            Free(e->path);
+            Free(e);
+            e = next;
+        }
+        buckets[i] = NULL;
+    }
+    free(cached_path_env);
+    cached_path_env = NULL;
+}
+
+void pathcache_list(void) {
+    int empty = 1;
+    for (int i = 0; i < PATHCACHE_BUCKETS; i++) {
+        for (pathcache_entry_t *e = buckets[i]; e != NULL; e = e->next) {
+            if (empty) {
+                printf("hits\tcommand\n");
+                empty = 0;
+            }
+            printf("%4lu\t%s\n", e->hits, e->path);
+        }
+    }
+    if (empty)
+        printf("hash: hash table empty\n");
+}
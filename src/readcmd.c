@@ -8,7 +8,24 @@
 #include <errno.h>
 #include <limits.h>
 #include <string.h>
+#include "csapp.h"
+#include "events.h"
 #include "readcmd.h"
+#include "scan.h"
+
+/* Script projeté en mémoire (readcmd_open_script) */
+static int from_script = 0;	/* 1 si les commandes sont lues dans le script, 0 sur l'entrée standard */
+static char *script_buf = NULL;
+static size_t script_len = 0;
+static size_t script_pos = 0;	/* Début de la prochaine ligne à lire dans script_buf */
+static size_t script_map_len = 0;	/* Taille de la projection (multiple de la taille de page) */
+
+/* Entrée standard lue par blocs (readline) */
+#define INPUT_MIN_BUF 4096
+static char *input_buf = NULL;
+static size_t input_size = 0;	/* Taille de input_buf */
+static size_t input_start = 0;	/* Début des données pas encore consommées */
+static size_t input_end = 0;	/* Fin des données lues */
 
 /**
  * @brief Déclenche une erreur de mémoire et quitte le programme
@@ -32,153 +49,499 @@ static void *xmalloc(size_t size)
 	return p;
 }
 
+/*
+ * Arène de la ligne courante : la ligne lue, les mots, les commandes, les séquences et les
+ * structures cmdline y sont alloués par simple incrément, puis tout est libéré d'un coup (O(1))
+ * au début de la lecture de la ligne suivante. Si une ligne a nécessité plusieurs blocs, ils sont
+ * remplacés par un seul bloc de la taille totale : en régime établi, aucune allocation par ligne.
+ */
+typedef struct arena_block {
+	struct arena_block *next;	/* Bloc précédent (plus petit) */
+	size_t size;			/* Taille de data */
+	size_t used;			/* Octets utilisés dans data */
+	char data[];
+} arena_block_t;
+
+#define ARENA_MIN_BLOCK 4096
+#define ARENA_ALIGN     sizeof(void *)	/* L'arène ne contient que des caractères, pointeurs et entiers */
+
+static arena_block_t *arena = 0;	/* Bloc courant */
+static unsigned long arena_mallocs = 0;	/* Nombre d'appels à malloc faits par l'arène */
+static unsigned long lines_read = 0;
+
+static size_t arena_round(size_t size)
+{
+	return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
 /**
- * @brief Réalloue de la mémoire et gère les erreurs d'allocation
- * 
- * @param ptr Pointeur vers la mémoire à réallouer
- * @param size Nouvelle taille de mémoire à allouer
- * @return void* Un pointeur vers la mémoire réallouée
+ * @brief Ajoute un bloc d'au moins size octets en tête de l'arène
  */
-static void *xrealloc(void *ptr, size_t size)
+static void arena_new_block(size_t size)
 {
-	void *p = realloc(ptr, size);
-	if (!p) memory_error();
+	size_t block_size = arena ? arena->size * 2 : ARENA_MIN_BLOCK;
+	arena_block_t *b;
+
+	while (block_size < size)
+		block_size *= 2;
+	b = xmalloc(sizeof(arena_block_t) + block_size);
+	arena_mallocs++;
+	b->next = arena;
+	b->size = block_size;
+	b->used = 0;
+	arena = b;
+}
+
+/**
+ * @brief Alloue size octets dans l'arène de la ligne courante
+ * @param size La taille à allouer
+ * @return void* Un pointeur valide jusqu'au prochain arena_reset()
+ */
+static void *arena_alloc(size_t size)
+{
+	void *p;
+
+	size = arena_round(size);
+	if (!arena || arena->size - arena->used < size)
+		arena_new_block(size);
+	p = arena->data + arena->used;
+	arena->used += size;
 	return p;
 }
 
+/**
+ * @brief Agrandit une allocation de l'arène, sur place si c'est la dernière et que le bloc le permet
+ * @param p L'allocation à agrandir
+ * @param old_size Sa taille actuelle
+ * @param new_size Sa nouvelle taille
+ * @return void* L'allocation agrandie (éventuellement déplacée, le contenu étant recopié)
+ */
+static void *arena_grow(void *p, size_t old_size, size_t new_size)
+{
+	char *q = p;
+	void *moved;
+
+	if (arena && q + arena_round(old_size) == arena->data + arena->used
+	    && (size_t)(q - arena->data) + arena_round(new_size) <= arena->size) {
+		arena->used = (q - arena->data) + arena_round(new_size);
+		return p;
+	}
+	moved = arena_alloc(new_size);
+	memcpy(moved, p, old_size);
+	return moved;
+}
+
+/**
+ * @brief Libère tout ce qui a été alloué pour la ligne précédente
+ */
+static void arena_reset(void)
+{
+	size_t total = 0;
+	arena_block_t *b;
+
+	if (!arena)
+		return;
+	if (arena->next) {
+		while ((b = arena) != 0) {
+			total += b->size;
+			arena = b->next;
+			free(b);
+		}
+		arena_new_block(total);
+	}
+	arena->used = 0;
+}
+
+/**
+ * @brief Libère tous les blocs de l'arène
+ */
+static void arena_free(void)
+{
+	arena_block_t *b;
+
+	while ((b = arena) != 0) {
+		arena = b->next;
+		free(b);
+	}
+}
+
+void readcmd_stats(unsigned long *lines, unsigned long *mallocs)
+{
+	*lines = lines_read;
+	*mallocs = arena_mallocs;
+}
+
+int readcmd_open_script(const char *path)
+{
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+	/* Script précédent éventuel */
+	if (script_buf) {
+		munmap(script_buf, script_map_len);
+		script_buf = NULL;
+	}
+	script_len = st.st_size;
+	script_pos = 0;
+	if (script_len == 0) {
+		/* Rien à projeter : le script vide se termine immédiatement */
+		from_script = 1;
+		close(fd);
+		return 0;
+	}
+
+	/* MAP_PRIVATE + PROT_WRITE : les mots sont terminés sur place par un '\0' (copie à l'écriture,
+	   le fichier n'est jamais modifié) */
+	script_map_len = script_len;
+	script_buf = Mmap(NULL, script_map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	madvise(script_buf, script_map_len, MADV_SEQUENTIAL);
+	close(fd);
+	from_script = 1;
+	return 0;
+}
+
+/**
+ * @brief Retourne la prochaine ligne du script projeté, terminée sur place (le '\n' est remplacé par '\0').
+ * @return char* Un pointeur vers la ligne, ou NULL à la fin du script
+ */
+static char *script_readline(void)
+{
+	char *line, *end;
+	size_t remaining;
+
+	if (script_pos >= script_len)
+		return NULL;
+
+	line = script_buf + script_pos;
+	remaining = script_len - script_pos;
+	end = memchr(line, '\n', remaining);
+	if (end != NULL) {
+		*end = '\0';
+		script_pos += end - line + 1;
+		return line;
+	}
+
+	/* Dernière ligne sans '\n' : l'octet qui suit la fin du fichier n'est accessible (et vaut déjà 0)
+	   que si la taille n'est pas un multiple de la taille de page, sinon la ligne est copiée dans l'arène */
+	script_pos = script_len;
+	if (script_len % sysconf(_SC_PAGESIZE) != 0)
+		return line;
+	end = arena_alloc(remaining + 1);
+	memcpy(end, line, remaining);
+	end[remaining] = '\0';
+	return end;
+}
+
 /**
  * @brief Lit une ligne de l'entrée standard et gère les erreurs d'entrée/sortie
+ *
+ * L'entrée est lue par blocs avec read() dans input_buf, et non avec fgets : la boucle d'événements
+ * ne voit que le descripteur, pas le buffer de stdio. On n'attend (events_wait) que lorsque le buffer
+ * ne contient plus de ligne complète ; les signaux arrivés entre-temps sont traités pendant l'attente.
+ * La ligne est recopiée dans l'arène.
  * @return char*  Un pointeur vers la ligne lue, ou NULL si l'entrée est fermée
  */
 static char *readline(void)
 {
-	size_t buf_len = 16;
-	char *buf = xmalloc(buf_len * sizeof(char));
+	char *line, *nl;
+	size_t len;
+	ssize_t n;
 
-	if (fgets(buf, buf_len, stdin) == NULL) {
-		free(buf);
-		return NULL;
-	}
-	
-	if (feof(stdin)) { /* End of file (ctrl-d) */
-	    fflush(stdout);
-	    exit(0);
-	}
+	for (;;) {
+		len = input_end - input_start;
+		nl = len > 0 ? memchr(input_buf + input_start, '\n', len) : NULL;
+		if (nl != NULL) {
+			len = nl - (input_buf + input_start);
+			line = arena_alloc(len + 1);
+			memcpy(line, input_buf + input_start, len);
+			line[len] = 0;
+			input_start += len + 1;
+			return line;
+		}
 
-	do {
-		size_t l = strlen(buf);
-		if ((l > 0) && (buf[l-1] == '\n')) {
-			l--;
-			buf[l] = 0;
-			return buf;
+		/* Pas de ligne complète : faire de la place à la suite des données en attente */
+		if (input_end == input_size) {
+			if (input_start > 0) {
+				memmove(input_buf, input_buf + input_start, len);
+			} else {
+				if (input_size >= (INT_MAX / 2)) memory_error();
+				input_size = input_size ? 2 * input_size : INPUT_MIN_BUF;
+				input_buf = realloc(input_buf, input_size);
+				if (!input_buf) memory_error();
+			}
+			input_start = 0;
+			input_end = len;
 		}
-		if (buf_len >= (INT_MAX / 2)) memory_error();
-		buf_len *= 2;
-		buf = xrealloc(buf, buf_len * sizeof(char));
-		if (fgets(buf + l, buf_len - l, stdin) == NULL) return buf;
-	} while (1);
+
+		events_wait(STDIN_FILENO);
+		n = read(STDIN_FILENO, input_buf + input_end, input_size - input_end);
+		if (n < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return NULL;
+		}
+		if (n == 0) { /* End of file (ctrl-d) */
+			if (len == 0)
+				return NULL;
+			/* Dernière ligne sans '\n' */
+			line = arena_alloc(len + 1);
+			memcpy(line, input_buf + input_start, len);
+			line[len] = 0;
+			input_start = input_end = 0;
+			return line;
+		}
+		input_end += n;
+	}
 }
 
 
 /**
- * @brief Divise une ligne en mots, en gérant les espaces, les tabulations et les caractères spéciaux (<, >, |)
+ * @brief Cherche la parenthèse fermante d'une substitution de processus, en tenant compte des
+ * parenthèses imbriquées
+ * @param s Le texte qui suit "<(" ou ">("
+ * @return char* La parenthèse fermante, ou NULL s'il n'y en a pas
+ */
+static char *find_closing_paren(char *s)
+{
+	int depth = 1;
+
+	for (; *s != '\0'; s++) {
+		if (*s == '(')
+			depth++;
+		else if (*s == ')' && --depth == 0)
+			return s;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Divise une ligne en mots, en gérant les espaces, les tabulations et les caractères spéciaux (<, <<, <<<, >, |, &, ;, ||, &&)
+ *
+ * Une substitution de processus "<(cmd)" ou ">(cmd)" forme un seul mot, sans la parenthèse fermante
+ * ("<(cmd"), analysé ensuite par parse_substitution.
+ *
+ * Les mots ne sont pas copiés : ils sont terminés sur place par un '\0' dans line, qui doit donc rester
+ * valide (et modifiable) tant que les mots sont utilisés. Un '#' en début de mot commence un commentaire.
  * 
- * @param line La ligne à diviser
- * @return char** Un tableau de chaînes de caractères représentant les mots de la ligne, terminé par un pointeur NULL
+ * @param line La ligne à diviser (modifiée)
+ * @return char** Un tableau (dans l'arène) de chaînes de caractères représentant les mots de la ligne, terminé par un pointeur NULL
  * Exemple : pour la ligne "ls -l | grep a > output.txt", le tableau retourné serait ["ls", "-l", "|", "grep", "a", ">", "output.txt", NULL]
  */
 static char **split_in_words(char *line)
 {
 	char *cur = line;
-	char **tab = 0;
+	size_t tab_len = 16;
+	char **tab = arena_alloc(tab_len * sizeof(char *));
 	size_t l = 0;
-	char c;
+	char c = *cur;	/* Caractère courant : peut différer de *cur si un '\0' de fin de mot l'a écrasé */
+	char *end;
 
-	while ((c = *cur) != 0) {
+	while (c != 0) {
 		char *w = 0;
 		char *start;
 		switch (c) {
 		case ' ':
 		case '\t':
 			/* Ignore any whitespace */
-			cur++;
+			c = *++cur;
 			break;
-		case '<':
-			w = "<";
-			cur++;
+		case '#':
+			/* Commentaire jusqu'à la fin de la ligne */
+			c = 0;
 			break;
+		case '<':
 		case '>':
-			w = ">";
-			cur++;
+			/* "<(cmd)" ou ">(cmd)" : un seul mot, recopié dans l'arène (le '<' ou '>' a pu être écrasé
+			   par la fin du mot précédent, voir c) */
+			if (cur[1] == '(' && (end = find_closing_paren(cur + 2)) != NULL) {
+				w = arena_alloc(end - cur + 1);
+				w[0] = c;
+				memcpy(w + 1, cur + 1, end - cur - 1);
+				w[end - cur] = '\0';
+				cur = end + 1;
+				c = *cur;
+				break;
+			}
+			/* "<<" et "<<<" : un seul mot, seulement si les '<' sont collés */
+			if (c == '<' && cur[1] == '<') {
+				w = (cur[2] == '<') ? "<<<" : "<<";
+				cur += strlen(w);
+			} else {
+				w = (c == '<') ? "<" : ">";
+				cur++;
+			}
+			c = *cur;
 			break;
 		case '|':
-			w = "|";
-			cur++;
+			/* "||" : opérateur ou, "|" : pipe */
+			if (cur[1] == '|') {
+				w = "||";
+				cur += 2;
+			} else {
+				w = "|";
+				cur++;
+			}
+			c = *cur;
 			break;
 		case '&':
-			w = "&";
-			cur++;
+			/* "&&" : opérateur et, "&" : arrière-plan */
+			if (cur[1] == '&') {
+				w = "&&";
+				cur += 2;
+			} else {
+				w = "&";
+				cur++;
+			}
+			c = *cur;
+			break;
+		case ';':
+			w = ";";
+			c = *++cur;
 			break;
 		default:
-			/* Another word */
+			/* Another word : fin au prochain délimiteur, cherché par blocs de 16 ou 32 octets */
 			start = cur;
-			while (c) {
-				c = *++cur;
-				switch (c) {
-				case 0:
-				case ' ':
-				case '\t':
-				case '<':
-				case '>':
-				case '|':
-				case '&':
-					c = 0;
-					break;
-				default: ;
-				}
-			}
-			w = xmalloc((cur - start + 1) * sizeof(char));
-			strncpy(w, start, cur - start);
-			w[cur - start] = 0;
+			cur = scan_delimiter(cur + 1);
+			c = *cur;
+			/* Termine le mot sur place : le délimiteur écrasé est conservé dans c */
+			*cur = 0;
+			w = start;
 		}
 		if (w) {
-			tab = xrealloc(tab, (l + 1) * sizeof(char *));
+			if (l + 1 == tab_len) { /* garder une place pour le NULL final */
+				tab = arena_grow(tab, tab_len * sizeof(char *), 2 * tab_len * sizeof(char *));
+				tab_len *= 2;
+			}
 			tab[l++] = w;
 		}
 	}
-	tab = xrealloc(tab, (l + 1) * sizeof(char *));
-	tab[l++] = 0;
+	tab[l] = 0;
 	return tab;
 }
 
 /**
- * @brief Libère la mémoire allouée pour une séquence de commandes
- * 
- * @param seq La séquence de commandes à libérer
+ * @brief Initialise une structure cmdline vide
+ *
+ * @param s La structure cmdline à initialiser
+ */
+static void initcmd(struct cmdline *s)
+{
+	s->err = 0;
+	s->in = 0;
+	s->in_data = 0;
+	s->in_len = 0;
+	s->subst = 0;
+	s->nb_subst = 0;
+	s->out = 0;
+	s->out_append = 0;
+	s->seq = 0;
+	s->background = 0;
+	s->next = 0;
+	s->next_op = SEQ_ALWAYS;
+}
+
+/**
+ * @brief Indique si un mot est un opérateur de séquencement (;, &&, ||)
  */
-static void freeseq(char ***seq)
+static int is_sequence_op(const char *w)
 {
-	int i, j;
+	return (w[0] == ';') || (w[0] == '&' && w[1] == '&') || (w[0] == '|' && w[1] == '|');
+}
+
+/**
+ * @brief Indique si un mot est un opérateur (<, <<, <<<, >, |, ||, &, &&, ;) : les autres mots ne
+ * commencent jamais par ces caractères, sauf les substitutions de processus "<(cmd" et ">(cmd".
+ */
+static int is_operator(const char *w)
+{
+	return (w[0] == '<' || w[0] == '>' || w[0] == '|' || w[0] == '&' || w[0] == ';') && w[1] != '(';
+}
 
-	for (i=0; seq[i]!=0; i++) {
-		char **cmd = seq[i];
+/**
+ * @brief Analyse le mot d'une substitution de processus ("<(cmd" ou ">(cmd", voir split_in_words) en
+ * une séquence de commandes simples reliées par des pipes, sans redirection ni substitution imbriquée.
+ * @param word Le mot (son texte après "<(" est découpé sur place)
+ * @param err Le message d'erreur éventuel
+ * @return char*** La séquence (dans l'arène), NULL en cas d'erreur
+ */
+static char ***parse_substitution(char *word, char **err)
+{
+	char **words = split_in_words(word + 2);
+	size_t nwords, cmd_len = 0, seq_len = 0;
+	char **cmd;
+	char ***seq;
 
-		for (j=0; cmd[j]!=0; j++) free(cmd[j]);
-		free(cmd);
+	for (nwords = 0; words[nwords] != 0; nwords++)
+		;
+	cmd = arena_alloc((2 * nwords + 1) * sizeof(char *));
+	seq = arena_alloc((nwords + 2) * sizeof(char **));
+	for (size_t i = 0; i < nwords; i++) {
+		char *w = words[i];
+		if (w[0] == '|' && w[1] == '\0' && cmd_len > 0) {
+			cmd[cmd_len] = 0;
+			seq[seq_len++] = cmd;
+			cmd += cmd_len + 1;
+			cmd_len = 0;
+		} else if (w[0] == '<' || w[0] == '>' || w[0] == '|' || w[0] == '&' || w[0] == ';') {
+			*err = (w[1] == '(') ? "nested process substitution not supported" :
+			       "only pipes are supported in process substitution";
+			return 0;
+		} else {
+			cmd[cmd_len++] = w;
+		}
+	}
+	if (cmd_len == 0) {
+		*err = (seq_len == 0) ? "empty process substitution" : "misplaced pipe";
+		return 0;
 	}
-	free(seq);
+	cmd[cmd_len] = 0;
+	seq[seq_len++] = cmd;
+	seq[seq_len] = 0;
+	return seq;
 }
 
 /**
- * @brief Libère la mémoire allouée pour une structure cmdline, sans libérer la structure elle-même
- * 
- * @param s La structure cmdline à libérer
+ * @brief Lit le corps d'un here-document : les lignes qui suivent la ligne de commande (dans le script
+ * ou sur l'entrée standard), jusqu'à une ligne égale au délimiteur ou à la fin de l'entrée.
+ * @param delim Le délimiteur
+ * @param len La taille du corps
+ * @return char* Le corps, chaque ligne terminée par '\n', dans l'arène de la ligne courante
  */
-static void freecmd(struct cmdline *s)
+static char *read_here_document(const char *delim, size_t *len)
 {
-	if (s->in) free(s->in);
-	if (s->out) free(s->out);
-	if (s->seq) freeseq(s->seq);
+	size_t size = 0, cap = 256;
+	char *body = arena_alloc(cap);
+	char *line;
+	size_t n;
+
+	for (;;) {
+		if (!from_script && isatty(STDIN_FILENO)) {
+			fputs("> ", stdout);
+			fflush(stdout);
+		}
+		line = from_script ? script_readline() : readline();
+		if (line == NULL || strcmp(line, delim) == 0)
+			break;
+		n = strlen(line);
+		if (size + n + 1 > cap) {
+			size_t new_cap = cap;
+			while (size + n + 1 > new_cap)
+				new_cap *= 2;
+			body = arena_grow(body, cap, new_cap);
+			cap = new_cap;
+		}
+		memcpy(body + size, line, n);
+		body[size + n] = '\n';
+		size += n + 1;
+	}
+	*len = size;
+	return body;
 }
 
 /**
@@ -187,151 +550,220 @@ static void freecmd(struct cmdline *s)
  */
 struct cmdline *readcmd(void)
 {
-	static struct cmdline *static_cmdline = 0;
-	struct cmdline *s = static_cmdline;
+	struct cmdline *s;
+	struct cmdline *cur;	/* Ligne de commande en cours d'analyse dans la séquence */
+	int pending_op = -1;	/* Opérateur (;, &&, ||) en attente de la commande suivante, -1 si aucun */
 	char *line;
 	char **words;
+	size_t nwords;
 	int i;
 	char *w;
-	char **cmd;
-	char ***seq;
+	char *err;
+	char **cmd;	/* Commande en cours, tranche de la réserve des commandes */
+	char ***seq;	/* Séquence en cours, tranche de la réserve des séquences */
 	size_t cmd_len, seq_len;
+	int n;
+
+	/* Tout ce qui avait été alloué pour la ligne précédente est libéré d'un coup */
+	arena_reset();
 
-	line = readline();
+	/* Ligne du script projeté (non copiée), ou de l'entrée standard (copiée dans l'arène) */
+	if (from_script)
+		line = script_readline();
+	else
+		line = readline();
 	if (line == NULL) {
-		if (s) {
-			freecmd(s);
-			free(s);
-		}
-		return static_cmdline = 0;
+		arena_free();
+		return 0;
 	}
+	lines_read++;
 
-	cmd = xmalloc(sizeof(char *));
-	cmd[0] = 0;
+	words = split_in_words(line);
+	for (nwords = 0; words[nwords] != 0; nwords++)
+		;
+
+	/* Les commandes de la ligne sont des tranches consécutives d'une seule réserve, chacune terminée
+	   par un NULL : au plus un mot et un NULL par mot. De même pour les séquences, avec en plus la
+	   séquence vide d'une ligne vide. */
+	cmd = arena_alloc((2 * nwords + 1) * sizeof(char *));
 	cmd_len = 0;
-	seq = xmalloc(sizeof(char **));
-	seq[0] = 0;
+	seq = arena_alloc((2 * nwords + 2) * sizeof(char **));
 	seq_len = 0;
 
-	words = split_in_words(line);
-	free(line);
-
-	if (!s)
-		static_cmdline = s = xmalloc(sizeof(struct cmdline));
-	else
-		freecmd(s);
-	s->err = 0;
-	s->in = 0;
-	s->out = 0;
-	s->out_append = 0;
-	s->seq = 0;
-	s->background = 0;
+	s = arena_alloc(sizeof(struct cmdline));
+	initcmd(s);
+	cur = s;
 
 	i = 0;
 	while ((w = words[i++]) != 0) {
+		/* Début d'une nouvelle ligne de commande après ;, && ou || */
+		if (pending_op != -1 && !is_sequence_op(w) && !(w[0] == '&' && w[1] == '\0')) {
+			struct cmdline *next = arena_alloc(sizeof(struct cmdline));
+			initcmd(next);
+			cur->next = next;
+			cur->next_op = pending_op;
+			cur = next;
+			pending_op = -1;
+		}
+
+		if (is_sequence_op(w)) {
+			/* Fin de la ligne de commande courante */
+			if (cmd_len == 0) {
+				err = (seq_len != 0) ? "misplaced pipe" :
+				      (w[0] == ';') ? "misplaced ;" :
+				      (w[0] == '&') ? "misplaced &&" : "misplaced ||";
+				goto error;
+			}
+			cmd[cmd_len] = 0;
+			seq[seq_len++] = cmd;
+			cmd += cmd_len + 1;
+			cmd_len = 0;
+			seq[seq_len] = 0;
+			cur->seq = seq;
+			seq += seq_len + 1;
+			seq_len = 0;
+
+			pending_op = (w[0] == ';') ? SEQ_ALWAYS : (w[0] == '&') ? SEQ_AND : SEQ_OR;
+			continue;
+		}
+
 		switch (w[0]) {
 		case '<':
-			/* Tricky : the word can only be "<" */
-			if (s->in) {
-				s->err = "only one input file supported";
+			if (w[1] == '(')
+				goto substitution;
+			/* Tricky : the word can only be "<", "<<" (here-document) ou "<<<" (here-string) */
+			n = strlen(w);
+			if (cur->in || cur->in_data) {
+				err = "only one input file supported";
 				goto error;
 			}
-			if (words[i] == 0) {
-				s->err = "filename missing for input redirection";
+			if (words[i] == 0 || is_operator(words[i])) {
+				err = (n == 1) ? "filename missing for input redirection" :
+				      (n == 2) ? "delimiter missing for here-document" : "word missing for here-string";
 				goto error;
 			}
-			s->in = words[i++];
+			if (n == 1) {
+				cur->in = words[i++];
+			} else if (n == 2) {
+				cur->in_data = read_here_document(words[i++], &cur->in_len);
+			} else {
+				/* Here-string : le mot suivi d'un '\n' */
+				w = words[i++];
+				cur->in_len = strlen(w) + 1;
+				cur->in_data = arena_alloc(cur->in_len);
+				memcpy(cur->in_data, w, cur->in_len - 1);
+				cur->in_data[cur->in_len - 1] = '\n';
+			}
 			break;
 		case '>':
+			if (w[1] == '(')
+				goto substitution;
 			/* Tricky : the word can only be ">" */
-			if (s->out) {
-				s->err = "only one output file supported";
+			if (cur->out) {
+				err = "only one output file supported";
 				goto error;
 			}
 			/* Regarde si le prochain mot est aussi ">" pour le mode append (>>) */
 			if (words[i] != 0 && words[i][0] == '>' && words[i][1] == '\0') {
-				s->out_append = 1;
+				cur->out_append = 1;
 				i++; // Passe le mot ">" supplémentaire
 				if (words[i] == 0) {
-					s->err = "filename missing for output redirection";
+					err = "filename missing for output redirection";
 					goto error;
 				}
-				s->out = words[i++];
+				cur->out = words[i++];
 			} else {
-				s->out_append = 0;
+				cur->out_append = 0;
 				if (words[i] == 0) {
-					s->err = "filename missing for output redirection";
+					err = "filename missing for output redirection";
 					goto error;
 				}
-				s->out = words[i++];
+				cur->out = words[i++];
 			}
 			break;
 		case '|':
 			/* Tricky : the word can only be "|" */
 			if (cmd_len == 0) {
-				s->err = "misplaced pipe";
+				err = "misplaced pipe";
 				goto error;
 			}
 
-			seq = xrealloc(seq, (seq_len + 2) * sizeof(char **));
+			cmd[cmd_len] = 0;
 			seq[seq_len++] = cmd;
-			seq[seq_len] = 0;
-
-			cmd = xmalloc(sizeof(char *));
-			cmd[0] = 0;
+			cmd += cmd_len + 1;
 			cmd_len = 0;
 			break;
 		case '&':
-			if (words[i] != 0) {
-				s->err = "& must be at the end of the command";
+			/* "&" termine la ligne de commande courante, exécutée en arrière-plan */
+			if (cmd_len == 0 || pending_op != -1) {
+				err = "misplaced &";
 				goto error;
 			}
-			s->background = 1;
+			if (words[i] != 0 && is_sequence_op(words[i])) {
+				err = "& must be followed by a command or be at the end of the line";
+				goto error;
+			}
+			cur->background = 1;
+			if (words[i] != 0) {
+				/* Commande suivante, exécutée sans condition */
+				cmd[cmd_len] = 0;
+				seq[seq_len++] = cmd;
+				cmd += cmd_len + 1;
+				cmd_len = 0;
+				seq[seq_len] = 0;
+				cur->seq = seq;
+				seq += seq_len + 1;
+				seq_len = 0;
+				pending_op = SEQ_ALWAYS;
+			}
 			break;
 		default:
-			cmd = xrealloc(cmd, (cmd_len + 2) * sizeof(char *));
 			cmd[cmd_len++] = w;
-			cmd[cmd_len] = 0;
+			break;
+		substitution: {
+			/* "<(cmd)" / ">(cmd)" : argument remplacé à l'exécution par /dev/fd/N ; le mot gardé
+			   dans la commande est le texte d'origine, pour l'affichage (jobs) */
+			struct procsubst *ps;
+			char *text = arena_alloc(strlen(w) + 2);
+			sprintf(text, "%s)", w);
+			if (cur->subst == 0)
+				cur->subst = arena_alloc(sizeof(struct procsubst));
+			else
+				cur->subst = arena_grow(cur->subst, cur->nb_subst * sizeof(struct procsubst),
+							(cur->nb_subst + 1) * sizeof(struct procsubst));
+			ps = &cur->subst[cur->nb_subst++];
+			ps->stage = seq_len;
+			ps->word = text;
+			ps->output = (w[0] == '>');
+			if ((ps->seq = parse_substitution(w, &err)) == 0)
+				goto error;
+			cmd[cmd_len++] = text;
+			break;
+		}
 		}
 	}
 
 	if (cmd_len != 0) {
-		seq = xrealloc(seq, (seq_len + 2) * sizeof(char **));
+		cmd[cmd_len] = 0;
 		seq[seq_len++] = cmd;
 		seq[seq_len] = 0;
+		cur->seq = seq;
 	} else if (seq_len != 0) {
-		s->err = "misplaced pipe";
-		i--;
+		err = "misplaced pipe";
 		goto error;
-	} else
-		free(cmd);
-	free(words);
-	s->seq = seq;
+	} else if (pending_op == SEQ_AND || pending_op == SEQ_OR) {
+		err = "command missing after && or ||";
+		goto error;
+	} else if (cur->seq == 0) {
+		seq[0] = 0;
+		cur->seq = seq; /* ligne vide : seq[0] est nul */
+	}
 	return s;
 error:
-	while ((w = words[i++]) != 0) {
-		switch (w[0]) {
-		case '<':
-		case '>':
-		case '|':
-		case '&':
-			break;
-		default:
-			free(w);
-		}
-	}
-	free(words);
-	freeseq(seq);
-	for (i=0; cmd[i]!=0; i++) free(cmd[i]);
-	free(cmd);
-	if (s->in) {
-		free(s->in);
-		s->in = 0;
-	}
-	if (s->out) {
-		free(s->out);
-		s->out = 0;
-	}
+	/* Les éléments déjà construits restent dans l'arène jusqu'à la ligne suivante */
+	s = arena_alloc(sizeof(struct cmdline));
+	initcmd(s);
+	s->err = err;
 	return s;
 }
 
@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include "scan.h"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/* Les versions vectorielles lisent le bloc aligné qui contient s, y compris les octets qui précèdent s :
+   la lecture reste dans la page de s, mais l'instrumentation d'ASan la signalerait à tort. */
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SCAN_NO_ASAN __attribute__((no_sanitize_address))
+#endif
+#endif
+#if !defined(SCAN_NO_ASAN) && defined(__SANITIZE_ADDRESS__)
+#define SCAN_NO_ASAN __attribute__((no_sanitize_address))
+#endif
+#ifndef SCAN_NO_ASAN
+#define SCAN_NO_ASAN
+#endif
+
+char *scan_delimiter_scalar(const char *s) {
+    for (;; s++) {
+        switch (*s) {
+        case 0:
+        case ' ':
+        case '\t':
+        case '<':
+        case '>':
+        case '|':
+        case '&':
+        case ';':
+            return (char *)s;
+        default: ;
+        }
+    }
+}
+
+#ifdef SCAN_X86
+
+/**
+ * @brief Masque des délimiteurs d'un bloc de 16 octets (bit i à 1 si l'octet i est un délimiteur).
+ */
+static inline unsigned delimiter_mask_sse2(__m128i v) {
+    __m128i m = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('|')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('&')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(';')));
+    return (unsigned)_mm_movemask_epi8(m);
+}
+
+SCAN_NO_ASAN
+static char *scan_delimiter_sse2(const char *s) {
+    uintptr_t offset = (uintptr_t)s & 15;
+    const __m128i *p = (const __m128i *)(s - offset);
+    unsigned mask = delimiter_mask_sse2(_mm_load_si128(p)) >> offset; // octets avant s ignorés
+
+    if (mask != 0)
+        return (char *)s + __builtin_ctz(mask);
+    for (;;) {
+        mask = delimiter_mask_sse2(_mm_load_si128(++p));
+        if (mask != 0)
+            return (char *)p + __builtin_ctz(mask);
+    }
+}
+
+/*
+ * Classification par quartets (vpshufb) : un octet est un délimiteur si les bits associés à son
+ * quartet bas et à son quartet haut ont une intersection non vide. Un bit par quartet haut utilisé :
+ *   bit 0 : 0x0_ ('\0' 0x00, '\t' 0x09)      bit 1 : 0x2_ (' ' 0x20, '&' 0x26)
+ *   bit 2 : 0x3_ (';' 0x3B, '<' 0x3C, '>' 0x3E)  bit 3 : 0x7_ ('|' 0x7C)
+ */
+#define LO_0 0x03 /* 0x00, 0x20 */
+#define LO_6 0x02 /* 0x26 */
+#define LO_9 0x01 /* 0x09 */
+#define LO_B 0x04 /* 0x3B */
+#define LO_C 0x0C /* 0x3C, 0x7C */
+#define LO_E 0x04 /* 0x3E */
+
+__attribute__((target("avx2")))
+static inline unsigned delimiter_mask_avx2(__m256i v) {
+    const __m256i lo_table = _mm256_setr_epi8(
+        LO_0, 0, 0, 0, 0, 0, LO_6, 0, 0, LO_9, 0, LO_B, LO_C, 0, LO_E, 0,
+        LO_0, 0, 0, 0, 0, 0, LO_6, 0, 0, LO_9, 0, LO_B, LO_C, 0, LO_E, 0);
+    const __m256i hi_table = _mm256_setr_epi8(
+        0x01, 0, 0x02, 0x04, 0, 0, 0, 0x08, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x01, 0, 0x02, 0x04, 0, 0, 0, 0x08, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, nibble));
+    __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+    return ~(unsigned)_mm256_movemask_epi8(none);
+}
+
+SCAN_NO_ASAN __attribute__((target("avx2")))
+static char *scan_delimiter_avx2(const char *s) {
+    uintptr_t offset = (uintptr_t)s & 31;
+    const __m256i *p = (const __m256i *)(s - offset);
+    unsigned mask = delimiter_mask_avx2(_mm256_load_si256(p)) >> offset; // octets avant s ignorés
+
+    if (mask != 0)
+        return (char *)s + __builtin_ctz(mask);
+    for (;;) {
+        mask = delimiter_mask_avx2(_mm256_load_si256(++p));
+        if (mask != 0)
+            return (char *)p + __builtin_ctz(mask);
+    }
+}
+
+#endif /* SCAN_X86 */
+
+static char *scan_resolve(const char *s);
+
+/* Implémentation courante, choisie au premier appel */
+static char *(*scan_impl)(const char *s) = scan_resolve;
+
+int scan_best(void) {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SCAN_AVX2;
+    return SCAN_SSE2;
+#else
+    return SCAN_SCALAR;
+#endif
+}
+
+int scan_select(int impl) {
+    if (impl < SCAN_SCALAR || impl > scan_best())
+        return -1;
+    switch (impl) {
+#ifdef SCAN_X86
+    case SCAN_AVX2:
+        scan_impl = scan_delimiter_avx2;
+        break;
+    case SCAN_SSE2:
+        scan_impl = scan_delimiter_sse2;
+        break;
+#endif
+    default:
+        scan_impl = scan_delimiter_scalar;
+    }
+    return 0;
+}
+
+static char *scan_resolve(const char *s) {
+    scan_select(scan_best());
+    return scan_impl(s);
+}
+
+char *scan_delimiter(const char *s) {
+    return scan_impl(s);
+}
@@ -4,46 +4,100 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "builtin.h"
 #include "execute.h"
+#include "forkserver.h"
+#include "notify.h"
+#include "trace.h"
 
 #ifdef DEBUG
 #define DEBUG_PRINT(...) printf("[DEBUG] : ") ;printf(__VA_ARGS__); 
 #endif
 
 
-int main()
+/**
+ * @brief Affiche l'usage du shell et quitte.
+ */
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-b] [-z] [script]\n", prog);
+	fprintf(stderr, "  -b      mode batch : pas de prompt (commandes envoyées sur l'entrée standard)\n");
+	fprintf(stderr, "  -z      lancer les commandes par un processus auxiliaire (serveur de lancement)\n");
+	fprintf(stderr, "  script  exécuter les commandes du fichier script (mode batch)\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
 {
 	#ifdef DEBUG
 	DEBUG_PRINT("Starting shell with parent PID %d\n", getpid()); 
 	#endif
 
-	int status;
+	// Processus auxiliaire du serveur de lancement (shell -z), ré-exécuté par forkserver_start
+	if (argc == 3 && strcmp(argv[1], "--fork-server") == 0)
+		forkserver_main(atoi(argv[2]));
+
+	int status = 0;
+	int batch = 0; // mode batch : pas de prompt ni de "exit" final
+	int fork_server = 0;
+
+	const char *script = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0)
+			batch = 1;
+		else if (strcmp(argv[i], "-z") == 0)
+			fork_server = 1;
+		else if (argv[i][0] != '-' && script == NULL)
+			script = argv[i];
+		else
+			usage(argv[0]);
+	}
+
+	// Script : projeté en mémoire et lu à la place de l'entrée standard, sans prompt
+	if (script != NULL) {
+		if (readcmd_open_script(script) < 0) {
+			perror(script);
+			exit(127);
+		}
+		batch = 1;
+	}
+
+	// Avant setup_signals_handlers_shell : l'auxiliaire garde le masque de signaux d'origine pour les commandes
+	if (fork_server && forkserver_start(argv[0]) < 0)
+		perror("fork server");
 	setup_signals_handlers_shell();
 	while (1) {
 		struct cmdline *l;
 
-		// Affichage du prompt
-		printf("shell> ");
-		fflush(stdout); // On doit s'assurer que le prompt est affiché avant de lire la commande
+		// Notifications des jobs (Stopped, Done) en attente, puis affichage du prompt
+		notify_flush();
+		if (!batch) {
+			printf("shell> ");
+			fflush(stdout); // On doit s'assurer que le prompt est affiché avant de lire la commande
+		}
 
 		// Lecture de la ligne de commande
+		TRACE(TRACE_READCMD_BEGIN, 0, 0);
 		l = readcmd();
+		TRACE(TRACE_READCMD_END, 0, 0);
 
 		if (!l) {
-			printf("exit\n");
-			exit(0);
+			notify_flush();
+			if (!batch)
+				printf("exit\n");
+			exit(status);
 		}
 		
 		// analyse de la ligne de commande
 		if (l->err) {
 			/* Syntax error, read another command */
 			printf("error: %s\n", l->err);
+			status = 2;
 			continue;
 		}
-		status = execute_builtin(l);
-		if (status == -1) {
-			status = execute_command_line(l);
-		}
+		// Exécution des lignes de commande séparées par ;, && et ||
+		status = execute_command_sequence(l);
 	}
 }
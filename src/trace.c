@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "csapp.h"
+#include "trace.h"
+
+/* Nombre d'événements de l'anneau (puissance de 2) : 64 Ki événements, 1,5 Mo */
+#define TRACE_RING (1u << 16)
+
+/**
+ * @brief Événement enregistré (24 octets).
+ */
+typedef struct {
+    uint64_t ts;    /* CLOCK_MONOTONIC, en nanosecondes */
+    int64_t  a;
+    int32_t  b;
+    uint32_t event;
+} trace_entry_t;
+
+int trace_enabled = 0;
+
+static trace_entry_t *ring = NULL;
+static uint64_t nb_recorded = 0; // événements enregistrés depuis le dernier trace_clear (le dernier est en nb_recorded - 1)
+
+/**
+ * @brief Nom, phase Chrome (B : début, E : fin, i : ponctuel) et noms des arguments de chaque événement.
+ */
+static const struct {
+    const char *name;
+    char        phase;
+    const char *arg_a;
+    const char *arg_b;
+} trace_events[TRACE_NB_EVENTS] = {
+    [TRACE_READCMD_BEGIN] = { "readcmd",   'B', NULL,     NULL },
+    [TRACE_READCMD_END]   = { "readcmd",   'E', NULL,     NULL },
+    [TRACE_EXECUTE_BEGIN] = { "execute",   'B', NULL,     NULL },
+    [TRACE_EXECUTE_END]   = { "execute",   'E', "status", NULL },
+    [TRACE_SPAWN_BEGIN]   = { "spawn",     'B', NULL,     NULL },
+    [TRACE_SPAWN_END]     = { "spawn",     'E', "pid",    NULL },
+    [TRACE_FORK]          = { "fork",      'i', "pid",    NULL },
+    [TRACE_SETPGID]       = { "setpgid",   'i', "pid",    "pgid" },
+    [TRACE_TCSETPGRP]     = { "tcsetpgrp", 'i', "pgid",   NULL },
+    [TRACE_SIGCHLD]       = { "sigchld",   'i', "pid",    "status" },
+    [TRACE_JOB_ADD]       = { "job_add",   'i', "jid",    "pgid" },
+    [TRACE_JOB_DELETE]    = { "job_delete", 'i', "jid",   "pgid" },
+};
+
+void trace_record(trace_event_t ev, int64_t a, int64_t b) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    trace_entry_t *e = &ring[nb_recorded++ & (TRACE_RING - 1)];
+    e->ts = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+    e->a = a;
+    e->b = (int32_t)b;
+    e->event = ev;
+}
+
+void trace_set_enabled(int on) {
+    if (on && ring == NULL)
+        ring = Malloc(TRACE_RING * sizeof(trace_entry_t));
+    trace_enabled = on;
+}
+
+void trace_clear(void) {
+    nb_recorded = 0;
+}
+
+int trace_dump(FILE *out) {
+    uint64_t first = nb_recorded > TRACE_RING ? nb_recorded - TRACE_RING : 0;
+    int pid = (int)getpid();
+    int nb = 0;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (uint64_t i = first; i < nb_recorded; i++) {
+        const trace_entry_t *e = &ring[i & (TRACE_RING - 1)];
+        const char *arg_a = trace_events[e->event].arg_a, *arg_b = trace_events[e->event].arg_b;
+        char phase = trace_events[e->event].phase;
+
+        // Horodatage en microsecondes (unité des traces Chrome), à la nanoseconde près
+        fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d",
+                nb > 0 ? "," : "", trace_events[e->event].name, phase,
+                (unsigned long long)(e->ts / 1000), (unsigned)(e->ts % 1000), pid, pid);
+        if (phase == 'i')
+            fprintf(out, ",\"s\":\"p\"");
+        if (arg_a != NULL) {
+            fprintf(out, ",\"args\":{\"%s\":%lld", arg_a, (long long)e->a);
+            if (arg_b != NULL)
+                fprintf(out, ",\"%s\":%d", arg_b, (int)e->b);
+            fprintf(out, "}");
+        }
+        fprintf(out, "}");
+        nb++;
+    }
+    fprintf(out, "\n]}\n");
+    return nb;
+}
+
+void trace_print_status(void) {
+    printf("trace: %s, %llu événements enregistrés", trace_enabled ? "on" : "off",
+           (unsigned long long)(nb_recorded < TRACE_RING ? nb_recorded : TRACE_RING));
+    if (nb_recorded > TRACE_RING)
+        printf(" (%llu plus anciens écrasés)", (unsigned long long)(nb_recorded - TRACE_RING));
+    printf("\n");
+}
@@ -0,0 +1,183 @@
+/*
+ * Tests de la table des jobs (jobs.c), lancés par "make check" :
+ *   1. table seule : 10 000 jobs ajoutés, retrouvés par jid et par pgid, supprimés au milieu,
+ *      job au premier plan et job courant, transitions atomiques et jobs terminés (JOB_DONE) ;
+ *   2. stress du shell : un script lance 10 000 jobs en arrière-plan simultanés, vérifie
+ *      qu'ils sont tous dans la table (jobs), puis le test les tue et attend que "wait" rende la main ;
+ *      jobs --stats compte au moins une paire de sigprocmask évitée par job lancé.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "jobs.h"
+
+#define NB_JOBS 10000
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            fprintf(stderr, "ECHEC ligne %d : ", __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Table seule, avec des pgid fictifs.
+ */
+static void test_table(void) {
+    char cmd[32];
+
+    jobs_init();
+    double t0 = now();
+    for (int i = 0; i < NB_JOBS; i++) {
+        snprintf(cmd, sizeof(cmd), "job %d", i + 1);
+        pid_t pgid = 100000 + 7 * i;
+        int jid = add_job(pgid, JOB_RUNNING, cmd, &pgid, 1);
+        CHECK(jid == i + 1, "add_job n°%d : jid %d", i + 1, jid);
+    }
+    double t1 = now();
+
+    for (int i = 0; i < NB_JOBS; i++) {
+        job_t *by_jid = get_job_by_jid(i + 1);
+        job_t *by_pgid = get_job_by_pgid(100000 + 7 * i);
+        CHECK(by_jid != NULL && by_jid == by_pgid, "job %d introuvable", i + 1);
+    }
+    double t2 = now();
+    CHECK(get_job_by_jid(NB_JOBS + 1) == NULL, "jid inexistant trouvé");
+    CHECK(get_job_by_pgid(42) == NULL, "pgid inexistant trouvé");
+    CHECK(has_running_jobs(), "has_running_jobs");
+
+    // Premier plan : O(1), et ignoré par le job courant
+    CHECK(get_fg_job() == NULL, "job au premier plan inattendu");
+    set_job_state(NB_JOBS, JOB_FOREGROUND);
+    CHECK(get_fg_job() == get_job_by_jid(NB_JOBS), "get_fg_job");
+    CHECK(get_current_job() == get_job_by_jid(NB_JOBS - 1), "get_current_job ignore le premier plan");
+    set_job_state_by_pgid(100000 + 7 * (NB_JOBS - 1), JOB_STOPPED);
+    CHECK(get_fg_job() == NULL, "premier plan non effacé");
+    CHECK(get_current_job() == get_job_by_jid(NB_JOBS), "get_current_job");
+
+    // Suppressions au milieu : les autres jobs restent accessibles, le jid suivant reste max + 1
+    for (int i = 0; i < NB_JOBS; i += 2)
+        CHECK(delete_job_by_pgid(100000 + 7 * i) == 0, "delete_job_by_pgid %d", i + 1);
+    CHECK(delete_job_by_jid(1) == -1, "job 1 supprimé deux fois");
+    for (int i = 1; i < NB_JOBS; i += 2)
+        CHECK(get_job_by_jid(i + 1) != NULL && get_job_by_jid(i + 1)->pgid == 100000 + 7 * i, "job %d perdu", i + 1);
+    CHECK(add_job(1, JOB_RUNNING, "recyclé", (pid_t[]){1}, 1) == NB_JOBS + 1, "jid après suppressions");
+
+    // Fin de job vue par le traitant SIGCHLD : invisible tout de suite, retirée au prochain add_job
+    job_t *last = get_job_by_jid(NB_JOBS + 1);
+    CHECK(mark_job_done(last, 0) == JOB_RUNNING, "mark_job_done");
+    CHECK(mark_job_done(last, 0) == -1, "job terminé deux fois");
+    CHECK(get_job_by_jid(NB_JOBS + 1) == NULL && get_job_by_pgid(1) == NULL, "job terminé encore visible");
+    CHECK(job_transition(last, JOB_ACTIVE_MASK, JOB_FOREGROUND) == -1, "transition depuis JOB_DONE");
+    CHECK(get_current_job() == get_job_by_jid(NB_JOBS), "get_current_job ignore les jobs terminés");
+    CHECK(add_job(3, JOB_RUNNING, "après fin", (pid_t[]){3}, 1) == NB_JOBS + 1, "jid après retrait du job terminé");
+    CHECK(mark_job_stopped(get_job_by_jid(NB_JOBS + 1)) == JOB_RUNNING, "mark_job_stopped");
+    CHECK(get_job_by_jid(NB_JOBS + 1)->state == JOB_STOPPED, "état après mark_job_stopped");
+
+    // Vider la table
+    for (int jid = 1; jid <= NB_JOBS + 1; jid++)
+        delete_job_by_jid(jid);
+    CHECK(!has_running_jobs(), "table non vide");
+    CHECK(get_current_job() == NULL, "job courant dans une table vide");
+    CHECK(add_job(2, JOB_RUNNING, "premier", (pid_t[]){2}, 1) == 1, "jid dans une table vide");
+    delete_job_by_jid(1);
+
+    printf("table : %d ajouts en %.1f ms, %d recherches en %.1f ms\n",
+           NB_JOBS, (t1 - t0) * 1e3, 2 * NB_JOBS, (t2 - t1) * 1e3);
+}
+
+/**
+ * @brief 10 000 jobs simultanés en arrière-plan dans le shell.
+ */
+static void test_shell(const char *shell) {
+    char script[] = "/tmp/test_jobsXXXXXX";
+    int fd = mkstemp(script);
+    FILE *f = fdopen(fd, "w");
+    for (int i = 0; i < NB_JOBS; i++)
+        fprintf(f, "sleep 600 &\n");
+    fprintf(f, "jobs\necho lances\nwait\necho fin\njobs --stats\n");
+    fclose(f);
+
+    int out[2];
+    if (pipe(out) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    double t0 = now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(out[1], STDOUT_FILENO);
+        close(out[0]);
+        close(out[1]);
+        execl(shell, shell, script, (char *)NULL);
+        perror(shell);
+        _exit(127);
+    }
+    close(out[1]);
+
+    static pid_t pgids[NB_JOBS];
+    int nb_launched = 0, nb_running = 0, nb_done = 0, full = 0, ended = 0;
+    unsigned long masks_avoided = 0;
+    int jid;
+    long pgid;
+    char line[1024];
+    double t1 = 0;
+    FILE *in = fdopen(out[0], "r");
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (strstr(line, "table pleine") != NULL) {
+            full++;
+        } else if (strcmp(line, "lances\n") == 0) {
+            // Tous les jobs sont lancés : les tuer pour que "wait" rende la main
+            t1 = now();
+            for (int i = 0; i < nb_launched; i++)
+                kill(-pgids[i], SIGTERM);
+        } else if (strcmp(line, "fin\n") == 0) {
+            ended = 1;
+        } else if (strncmp(line, "sigprocmask", 11) == 0) {
+            sscanf(line, "sigprocmask évités : %lu", &masks_avoided);
+        } else if (strstr(line, " Running ") != NULL) {
+            nb_running++;
+        } else if (strstr(line, " Done ") != NULL) {
+            nb_done++;
+        } else if (sscanf(line, "[%d] %ld", &jid, &pgid) == 2 && nb_launched < NB_JOBS) {
+            CHECK(jid == nb_launched + 1, "jid %d au lieu de %d", jid, nb_launched + 1);
+            pgids[nb_launched++] = (pid_t)pgid;
+        }
+    }
+    fclose(in);
+    int status;
+    waitpid(pid, &status, 0);
+    unlink(script);
+
+    CHECK(full == 0, "%d messages \"table pleine\"", full);
+    CHECK(nb_launched == NB_JOBS, "%d jobs lancés sur %d", nb_launched, NB_JOBS);
+    CHECK(nb_running == NB_JOBS, "%d jobs listés par jobs sur %d", nb_running, NB_JOBS);
+    CHECK(nb_done == NB_JOBS, "%d notifications Done sur %d", nb_done, NB_JOBS);
+    CHECK(ended, "wait n'a pas rendu la main");
+    CHECK(masks_avoided >= 2 * NB_JOBS, "%lu sigprocmask évités pour %d jobs", masks_avoided, NB_JOBS);
+    printf("shell : %d jobs simultanés lancés en %.1f s, terminés et attendus en %.1f s\n",
+           nb_launched, t1 - t0, now() - t1);
+}
+
+int main(int argc, char *argv[]) {
+    test_table();
+    test_shell(argc > 1 ? argv[1] : "./shell");
+    printf("%s\n", failures == 0 ? "OK" : "ECHEC");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*
+ * Test différentiel de la recherche de délimiteurs (scan) : chaque implémentation vectorielle
+ * disponible doit donner exactement le même résultat que l'implémentation scalaire,
+ * puis readcmd() doit produire le même découpage en mots quelle que soit l'implémentation.
+ *
+ * Lancé par "make check".
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "readcmd.h"
+#include "scan.h"
+
+static const char *impl_names[] = {"scalar", "sse2", "avx2"};
+
+/* Alphabet riche en délimiteurs (et parenthèses des substitutions de processus), avec des octets non ASCII */
+static const char alphabet[] = "ab \t<>|&;#()-_/.\x80\xff" "xyz0123456789";
+
+static int failures = 0;
+
+/**
+ * @brief Compare l'implémentation impl à la référence scalaire pour chaque début possible dans buf.
+ */
+static void check_buffer(int impl, const char *buf, size_t len) {
+    for (size_t start = 0; start <= len; start++) {
+        char *expected = scan_delimiter_scalar(buf + start);
+        char *got = scan_delimiter(buf + start);
+        if (got != expected) {
+            fprintf(stderr, "%s: début %zu de \"%s\" : délimiteur attendu en %td, trouvé en %td\n",
+                    impl_names[impl], start, buf, expected - buf, got - buf);
+            failures++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Tests sur des chaînes aléatoires de toutes longueurs, à tous les alignements.
+ */
+static void check_scanner(int impl) {
+    static char storage[4096 + 64] __attribute__((aligned(64)));
+
+    srand(42);
+    for (int iter = 0; iter < 20000; iter++) {
+        size_t align = iter % 64;
+        size_t len = rand() % (iter % 10 == 0 ? 1000 : 80);
+        char *buf = storage + align;
+        // Parfois des mots longs, sans aucun délimiteur
+        int sparse = iter % 3 == 0;
+
+        for (size_t i = 0; i < len; i++) {
+            if (sparse && rand() % 200 != 0)
+                buf[i] = 'a' + rand() % 26;
+            else
+                buf[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+        buf[len] = '\0';
+        check_buffer(impl, buf, len);
+    }
+}
+
+/**
+ * @brief Sérialise une ligne analysée par readcmd (mots, redirections, séquences) dans out.
+ */
+static void dump_cmdline(struct cmdline *l, FILE *out) {
+    if (l->err) {
+        fprintf(out, "err:%s\n", l->err);
+        return;
+    }
+    for (; l != NULL; l = l->next) {
+        fprintf(out, "in:%s out:%s app:%d bg:%d op:%d", l->in ? l->in : "-", l->out ? l->out : "-",
+                l->out_append, l->background, l->next_op);
+        for (int k = 0; k < l->nb_subst; k++) { // substitutions de processus : étape, sens et séquence
+            fprintf(out, " subst:%d%c", l->subst[k].stage, l->subst[k].output ? '>' : '<');
+            for (int i = 0; l->subst[k].seq[i] != NULL; i++)
+                for (int j = 0; l->subst[k].seq[i][j] != NULL; j++)
+                    fprintf(out, "%s<%s>", j == 0 ? "[" : "", l->subst[k].seq[i][j]);
+        }
+        if (l->in_data != NULL) { // here-document ou here-string : les lignes suivantes y sont lues
+            fprintf(out, " here:%zu:", l->in_len);
+            fwrite(l->in_data, 1, l->in_len, out);
+        }
+        for (int i = 0; l->seq[i] != NULL; i++) {
+            fprintf(out, " [");
+            for (int j = 0; l->seq[i][j] != NULL; j++)
+                fprintf(out, "<%s>", l->seq[i][j]);
+            fprintf(out, "]");
+        }
+        fprintf(out, "\n");
+    }
+}
+
+/**
+ * @brief Analyse le script path avec l'implémentation impl et retourne la sérialisation du résultat.
+ */
+static char *parse_script(int impl, const char *path) {
+    char *result = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&result, &size);
+    struct cmdline *l;
+
+    scan_select(impl);
+    if (readcmd_open_script(path) < 0) {
+        perror(path);
+        exit(1);
+    }
+    while ((l = readcmd()) != NULL)
+        dump_cmdline(l, out);
+    fclose(out);
+    return result;
+}
+
+/**
+ * @brief Compare le découpage de lignes aléatoires par readcmd entre la référence scalaire et impl.
+ */
+static void check_readcmd(int impl, const char *path, const char *reference) {
+    char *result = parse_script(impl, path);
+    if (strcmp(result, reference) != 0) {
+        fprintf(stderr, "%s: découpage de readcmd différent de la référence scalaire\n", impl_names[impl]);
+        failures++;
+    }
+    free(result);
+}
+
+int main(void) {
+    char path[] = "/tmp/test_scanXXXXXX";
+    int fd = mkstemp(path);
+    FILE *f = fdopen(fd, "w");
+
+    // Lignes aléatoires, y compris avec des mots longs
+    srand(7);
+    for (int i = 0; i < 5000; i++) {
+        int len = rand() % (i % 50 == 0 ? 2000 : 120);
+        for (int j = 0; j < len; j++)
+            fputc(rand() % 4 == 0 ? alphabet[rand() % (sizeof(alphabet) - 1)] : 'a' + rand() % 26, f);
+        fputc('\n', f);
+    }
+    fclose(f);
+
+    char *reference = parse_script(SCAN_SCALAR, path);
+    int best = scan_best();
+
+    for (int impl = SCAN_SCALAR; impl <= SCAN_AVX2; impl++) {
+        if (scan_select(impl) < 0) {
+            printf("%s: non disponible sur ce processeur\n", impl_names[impl]);
+            continue;
+        }
+        int before = failures;
+        check_scanner(impl);
+        check_readcmd(impl, path, reference);
+        printf("%s: %s%s\n", impl_names[impl], failures == before ? "OK" : "ECHEC",
+               impl == best ? " (implémentation par défaut)" : "");
+    }
+
+    unlink(path);
+    free(reference);
+    return failures == 0 ? 0 : 1;
+}